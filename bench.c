@@ -0,0 +1,597 @@
+/* Benchmarks, run `./bench` for all of them or `./bench NAME...` for some.
+   The Makefile also builds variants with different compile-time options. */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <pthread.h>
+#define VECTOR_IMPLEMENTATION
+#include "vector.h"
+#include "vector_pipe.h"
+#include "jagged_vector.h"
+#include "sorted_vector.h"
+#include "hash_map.h"
+#include "string_vector.h"
+
+static double
+now (void)
+{
+  struct timespec ts;
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* Resident set size in KiB. */
+static long
+rss_kib (void)
+{
+  long pages = 0, resident = 0;
+  FILE *f = fopen ("/proc/self/statm", "r");
+  if (f)
+    {
+      if (fscanf (f, "%ld %ld", &pages, &resident) != 2)
+        resident = 0;
+      fclose (f);
+    }
+  return resident * 4;
+}
+
+/* Adjacency lists: many vectors with only a few elements each. */
+static void
+bench_tiny_vectors (void)
+{
+  enum { COUNT = 4000000 };
+  static const size_t sizes[] = { 2, 4 };
+  printf ("tiny_vectors: sizeof (struct vector__header) = %zu\n",
+          sizeof (struct vector__header));
+  fflush (stdout);
+  for (size_t s = 0; s < sizeof (sizes) / sizeof (*sizes); ++s)
+    {
+      /* Run each size in a fresh process so freed memory is not reused. */
+      if (fork () != 0)
+        {
+          wait (NULL);
+          continue;
+        }
+      VECTOR(VECTOR(int)) lists = vector_create (VECTOR(int), COUNT);
+      memset (lists, 0, COUNT * sizeof (*lists));
+      const long before = rss_kib ();
+      const double start = now ();
+      for (int i = 0; i < COUNT; ++i)
+        {
+          VECTOR(int) l = vector_create (int, sizes[s]);
+          for (size_t j = 0; j < sizes[s]; ++j)
+            vector_push (l, i + (int)j);
+          vector_push (lists, l);
+        }
+      const double elapsed = now () - start;
+      printf ("  %d vectors of %zu ints: %8ld KiB RSS, %.1f bytes/vector, %.3fs\n",
+              COUNT, sizes[s], rss_kib () - before,
+              (rss_kib () - before) * 1024.0 / COUNT, elapsed);
+      vector_for_each (lists, l)
+        vector_free (*l);
+      vector_free (lists);
+      exit (0);
+    }
+}
+
+/* Request path: short-lived vectors from vector_create, vector_clone,
+   vector_slice and vector_select that are freed right away. The small ones
+   are served about as fast by the tcache of glibc, the cache pays off for
+   blocks of a few KiB of varying size that malloc has to split and merge. */
+static void
+bench_create_free (void)
+{
+  enum { ROUNDS = 2000000 };
+  VECTOR(int) base = vector_create (int, 64);
+  long checksum = 0;
+  for (int i = 0; i < 64; ++i)
+    vector_push (base, i);
+  double start = now ();
+  for (int r = 0; r < ROUNDS; ++r)
+    {
+      VECTOR(int) v = vector_create (int, 16);
+      for (int i = 0; i < 16; ++i)
+        vector_push (v, r + i);
+      VECTOR(int) c = vector_clone (base);
+      VECTOR(int) s = vector_slice (base, r % 32, 48);
+      VECTOR(int) sel = vector_select (base, 1, 3, 5, -1);
+      checksum += v[3] + c[5] + s[0] + sel[2];
+      vector_free (sel);
+      vector_free (s);
+      vector_free (c);
+      vector_free (v);
+    }
+  double elapsed = now () - start;
+  printf ("create_free: %d rounds of 4 vectors: %.3fs, %.1f ns/vector (%ld)\n",
+          ROUNDS, elapsed, elapsed * 1e9 / (4.0 * ROUNDS), checksum);
+  unsigned x = 1;
+  start = now ();
+  for (int r = 0; r < ROUNDS; ++r)
+    {
+      VECTOR(int) v[4];
+      for (int k = 0; k < 4; ++k)
+        {
+          x = x * 1103515245 + 12345;
+          v[k] = vector_create (int, 1000 + (x >> 16) % 12000);
+          vector_push (v[k], r);
+        }
+      for (int k = 0; k < 4; ++k)
+        {
+          checksum += v[k][0];
+          vector_free (v[k]);
+        }
+    }
+  elapsed = now () - start;
+  printf ("create_free: %d rounds of 4 vectors of 4-52 KiB: %.3fs, %.1f ns/vector (%ld)\n",
+          ROUNDS, elapsed, elapsed * 1e9 / (4.0 * ROUNDS), checksum);
+  vector_free (base);
+#ifdef VECTOR_CACHE
+  vector_cache_flush ();
+#endif
+}
+
+/* map -> filter -> take -> sum, fused into one loop versus materializing a
+   vector after each step. */
+static void
+bench_pipe (void)
+{
+  enum { COUNT = 2000000, ROUNDS = 20 };
+  VECTOR(int) v = vector_create (int, COUNT);
+  for (int i = 0; i < COUNT; ++i)
+    vector_push (v, (int)(i * 7919L % 1000));
+  long fused_sum = 0, step_sum = 0;
+  double start = now ();
+  for (int r = 0; r < ROUNDS; ++r)
+    {
+      VECTOR(long) out = NULL;
+      vector_pipe_collect (out, v, x, map ((long)x * 3 + r), filter (x % 4 != 0),
+                           take (COUNT / 2));
+      vector_pipe_reduce (fused_sum, fused_sum + x, out, x);
+      vector_free (out);
+    }
+  const double fused = now () - start;
+  start = now ();
+  for (int r = 0; r < ROUNDS; ++r)
+    {
+      VECTOR(long) mapped = NULL;
+      VECTOR(long) filtered = NULL;
+      vector_for_each (v, x)
+        vector_push (mapped, (long)*x * 3 + r);
+      vector_for_each (mapped, x)
+        if (*x % 4 != 0)
+          vector_push (filtered, *x);
+      VECTOR(long) taken = vector_slice (filtered, 0, COUNT / 2);
+      vector_for_each (taken, x)
+        step_sum += *x;
+      vector_free (taken);
+      vector_free (filtered);
+      vector_free (mapped);
+    }
+  const double steps = now () - start;
+  printf ("pipe: %d elements x %d: fused %.3fs, materialized %.3fs (%s)\n",
+          COUNT, ROUNDS, fused, steps, fused_sum == step_sum ? "ok" : "MISMATCH");
+  vector_free (v);
+}
+
+/* Adjacency lists as VECTOR(VECTOR(int)) versus a jagged vector: memory of
+   building them and the time to sum all elements. */
+static void
+bench_jagged (void)
+{
+  enum { ROWS = 1000000, ROUNDS = 20 };
+  printf ("jagged: %d rows of 0-15 ints\n", ROWS);
+  fflush (stdout);
+  for (int layout = 0; layout < 2; ++layout)
+    {
+      if (fork () != 0)
+        {
+          wait (NULL);
+          continue;
+        }
+      VECTOR(VECTOR(int)) nested = vector_create (VECTOR(int), ROWS);
+      memset (nested, 0, ROWS * sizeof (*nested));
+      JAGGED_VECTOR(int) j = {0};
+      const long before = rss_kib ();
+      for (int r = 0; r < ROWS; ++r)
+        {
+          const int n = (r * 7) % 16;
+          if (layout == 0)
+            {
+              VECTOR(int) row = vector_create (int, n);
+              for (int k = 0; k < n; ++k)
+                vector_push (row, r + k);
+              vector_push (nested, row);
+            }
+          else
+            {
+              jagged_vector_new_row (j);
+              for (int k = 0; k < n; ++k)
+                jagged_vector_push (j, r + k);
+            }
+        }
+      const long rss = rss_kib () - before;
+      long sum = 0;
+      const double start = now ();
+      for (int round = 0; round < ROUNDS; ++round)
+        {
+          if (layout == 0)
+            {
+              vector_for_each (nested, row)
+                vector_for_each (*row, it)
+                  sum += *it;
+            }
+          else
+            {
+              jagged_vector_for_each_row (j, r)
+                jagged_vector_for_each_in_row (j, r, it)
+                  sum += *it;
+            }
+        }
+      printf ("  %-8s %8ld KiB RSS, sum x %d: %.3fs (%ld)\n",
+              layout == 0 ? "nested" : "jagged", rss, ROUNDS, now () - start,
+              sum);
+      exit (0);
+    }
+}
+
+static volatile int hot_stop;
+static long hot_passes;
+
+/* Keeps walking a small working set that fits in the cache. */
+static void *
+hot_loop (void *arg)
+{
+  const VECTOR(long) hot = arg;
+  long sum = 0;
+  hot_passes = 0;
+  while (!hot_stop)
+    {
+      for (size_t i = 0; i < vector_size (hot); i += 8)
+        sum += hot[i];
+      ++hot_passes;
+    }
+  return (void *)sum;
+}
+
+/* Large vector_copy with plain and with streaming stores: copy bandwidth and
+   how many passes a concurrent thread gets over its hot working set. */
+static void
+bench_streaming (void)
+{
+  enum { MAX_BYTES = 256 << 20, HOT = 1 << 20, TOTAL = 1024 << 20 };
+  static const size_t sizes[] = { 32 << 20, MAX_BYTES };
+  VECTOR(char) src = vector_create (char, MAX_BYTES);
+  VECTOR(char) dst = vector_create (char, MAX_BYTES);
+  VECTOR(long) hot = vector_create (long, HOT / sizeof (long));
+  memset (src, 1, MAX_BYTES);
+  memset (dst, 0, MAX_BYTES);
+  memset (hot, 0, HOT);
+  vector__size (hot) = HOT / sizeof (long);
+  printf ("streaming: %d KiB hot set, threshold %zu bytes\n",
+          HOT >> 10, vector__streaming_threshold ());
+  for (size_t s = 0; s < sizeof (sizes) / sizeof (*sizes); ++s)
+    for (int streaming = 0; streaming < 2; ++streaming)
+      {
+        const size_t rounds = TOTAL / sizes[s];
+        pthread_t thread;
+        vector__size (src) = sizes[s];
+        hot_stop = 0;
+        pthread_create (&thread, NULL, hot_loop, hot);
+        const double start = now ();
+        for (size_t r = 0; r < rounds; ++r)
+          {
+            if (streaming)
+              vector_copy_streaming (dst, src);
+            else
+              {
+                vector_set_streaming_threshold (SIZE_MAX);
+                vector_copy (dst, src);
+                vector_set_streaming_threshold (0);
+              }
+          }
+        const double elapsed = now () - start;
+        hot_stop = 1;
+        pthread_join (thread, NULL);
+        printf ("  %3zu MiB %-9s %6.2f GB/s, hot set %8.0f passes/s\n",
+                sizes[s] >> 20, streaming ? "streaming" : "memcpy",
+                (double)sizes[s] * rounds / elapsed / 1e9,
+                hot_passes / elapsed);
+      }
+  vector_free (hot);
+  vector_free (dst);
+  vector_free (src);
+}
+
+static int
+compare_int (const void *a, const void *b)
+{
+  return (*(const int *)a > *(const int *)b) - (*(const int *)a < *(const int *)b);
+}
+
+/* Merging sorted partial results: vector_push_vector of all parts followed
+   by qsort versus vector_merge. */
+static void
+bench_merge (void)
+{
+  enum { PARTS = 16, COUNT = 500000 };
+  VECTOR(int) parts[PARTS];
+  unsigned x = 1;
+  for (int k = 0; k < PARTS; ++k)
+    {
+      parts[k] = vector_create (int, COUNT);
+      for (int i = 0; i < COUNT; ++i)
+        {
+          x = x * 1103515245 + 12345;
+          vector_push (parts[k], (int)(x >> 1));
+        }
+      qsort (parts[k], COUNT, sizeof (int), compare_int);
+    }
+  double start = now ();
+  VECTOR(int) sorted = NULL;
+  for (int k = 0; k < PARTS; ++k)
+    vector_push_vector (sorted, parts[k]);
+  qsort (sorted, vector_size (sorted), sizeof (int), compare_int);
+  const double push_sort = now () - start;
+  start = now ();
+  VECTOR(int) merged = NULL;
+  vector_merge (merged, parts, PARTS, compare_int);
+  const double merge = now () - start;
+  printf ("merge: %d parts of %d ints: push+qsort %.3fs, vector_merge %.3fs (%s)\n",
+          PARTS, COUNT, push_sort, merge,
+          vector_compare (sorted, merged) == 0 ? "ok" : "MISMATCH");
+  vector_free (merged);
+  vector_free (sorted);
+  for (int k = 0; k < PARTS; ++k)
+    vector_free (parts[k]);
+}
+
+/* Intersection of sorted ids with the generic function and the integer fast
+   path, for inputs of similar and of very different sizes. */
+static void
+bench_intersect (void)
+{
+  enum { RANGE = 6000000, ROUNDS = 20 };
+  static const unsigned small_density[] = { 2, 1000 };
+  VECTOR(int32_t) big = NULL;
+  unsigned x = 1;
+  for (int i = 0; i < RANGE; ++i)
+    if ((x = x * 1103515245 + 12345) >> 16 & 1)
+      vector_push (big, i);
+  for (size_t s = 0; s < sizeof (small_density) / sizeof (*small_density); ++s)
+    {
+      VECTOR(int32_t) small = NULL;
+      VECTOR(int32_t) out = NULL;
+      for (int i = 0; i < RANGE; ++i)
+        if (((x = x * 1103515245 + 12345) >> 8) % small_density[s] == 0)
+          vector_push (small, i);
+      double start = now ();
+      for (int r = 0; r < ROUNDS; ++r)
+        {
+          vector_clear (out);
+          vector_intersection (out, small, big, compare_int);
+        }
+      const double generic = now () - start;
+      const size_t found = vector_size (out);
+      start = now ();
+      for (int r = 0; r < ROUNDS; ++r)
+        {
+          vector_clear (out);
+          vector_intersection_i32 (out, small, big);
+        }
+      const double fast = now () - start;
+      printf ("intersect: %zu and %zu ints x %d: generic %.3fs, i32 %.3fs (%s)\n",
+              vector_size (small), vector_size (big), ROUNDS, generic, fast,
+              found == vector_size (out) ? "ok" : "MISMATCH");
+      vector_free (out);
+      vector_free (small);
+    }
+  vector_free (big);
+}
+
+static int
+compare_float (const void *a, const void *b)
+{
+  return (*(const float *)a > *(const float *)b) - (*(const float *)a < *(const float *)b);
+}
+
+static int
+compare_float_descending (const void *a, const void *b)
+{
+  return compare_float (b, a);
+}
+
+/* The 100 highest of 10M random scores: qsort of everything, then
+   vector_partial_sort, vector_topk and vector_topk_f32. */
+static void
+bench_topk (void)
+{
+  enum { COUNT = 10000000, K = 100 };
+  VECTOR(float) scores = vector_create (float, COUNT);
+  VECTOR(float) work = NULL;
+  VECTOR(float) top = NULL;
+  VECTOR(float) top_f32 = NULL;
+  unsigned x = 1;
+  for (int i = 0; i < COUNT; ++i)
+    {
+      x = x * 1103515245 + 12345;
+      vector_push (scores, (float)(x >> 8) / (1 << 24));
+    }
+  vector_copy (work, scores);
+  double start = now ();
+  qsort (work, COUNT, sizeof (float), compare_float_descending);
+  const double sort = now () - start;
+  vector_copy (work, scores);
+  start = now ();
+  vector_partial_sort (work, K, compare_float_descending);
+  const double partial = now () - start;
+  start = now ();
+  vector_topk (top, scores, K, compare_float);
+  const double topk = now () - start;
+  start = now ();
+  vector_topk_f32 (top_f32, scores, K);
+  const double topk_f32 = now () - start;
+  printf ("topk: %d of %d floats: qsort %.3fs, vector_partial_sort %.3fs, "
+          "vector_topk %.3fs, vector_topk_f32 %.3fs (%s)\n",
+          K, COUNT, sort, partial, topk, topk_f32,
+          !memcmp (work, top, K * sizeof (float))
+          && !memcmp (top, top_f32, K * sizeof (float)) ? "ok" : "MISMATCH");
+  vector_free (top_f32);
+  vector_free (top);
+  vector_free (work);
+  vector_free (scores);
+}
+
+/* hm_put, hm_get hits and misses, iteration and hm_del with 64-bit keys. */
+static void
+bench_hash_map (void)
+{
+  enum { COUNT = 2000000 };
+  struct { uint64_t key; uint64_t value; } *m = NULL;
+  uint64_t sum = 0;
+  double start = now ();
+  for (uint64_t i = 0; i < COUNT; ++i)
+    hm_put (m, i * 0x9e3779b97f4a7c15, i);
+  const double put = now () - start;
+  start = now ();
+  for (uint64_t i = 0; i < COUNT; ++i)
+    sum += hm_get (m, i * 0x9e3779b97f4a7c15)->value;
+  const double hit = now () - start;
+  start = now ();
+  for (uint64_t i = 0; i < COUNT; ++i)
+    sum += hm_get (m, i * 0x9e3779b97f4a7c15 + 1) != NULL;
+  const double miss = now () - start;
+  start = now ();
+  for (int r = 0; r < 10; ++r)
+    hm_for_each (m, it)
+      sum += it->value;
+  const double iterate = (now () - start) / 10;
+  start = now ();
+  for (uint64_t i = 0; i < COUNT; ++i)
+    hm_del (m, i * 0x9e3779b97f4a7c15);
+  const double del = now () - start;
+  printf ("hash_map: %d entries: put %.1f, get %.1f, miss %.1f, iterate %.2f, "
+          "del %.1f ns/entry (%zu, %llu)\n",
+          COUNT, put * 1e9 / COUNT, hit * 1e9 / COUNT, miss * 1e9 / COUNT,
+          iterate * 1e9 / COUNT, del * 1e9 / COUNT, hm_size (m),
+          (unsigned long long)sum);
+  hm_free (m);
+}
+
+/* Building a response of "id=N size=M\n" lines: snprintf into a buffer and
+   vector_push_vector, vector_appendf and the integer appenders. */
+static void
+bench_strings (void)
+{
+  enum { LINES = 2000000 };
+  VECTOR(char) out = NULL;
+  VECTOR(char) line = vector_create (char, 64);
+  size_t sizes[3];
+  double times[3];
+  for (int method = 0; method < 3; ++method)
+    {
+      vector_clear (out);
+      const double start = now ();
+      for (int i = 0; i < LINES; ++i)
+        {
+          const unsigned size = i * 7u;
+          switch (method)
+            {
+            case 0:
+              vector__size (line) = snprintf (line, 64, "id=%d size=%u\n",
+                                              i, size);
+              vector_push_vector (out, line);
+              break;
+            case 1:
+              vector_appendf (out, "id=%d size=%u\n", i, size);
+              break;
+            default:
+              vector_append_mem (out, "id=", 3);
+              vector_append_int (out, i);
+              vector_append_mem (out, " size=", 6);
+              vector_append_uint (out, size);
+              vector_append_mem (out, "\n", 1);
+            }
+        }
+      times[method] = now () - start;
+      sizes[method] = vector_size (out);
+    }
+  printf ("strings: %d lines: snprintf+push %.3fs, appendf %.3fs, "
+          "append_int %.3fs (%s)\n", LINES, times[0], times[1], times[2],
+          sizes[0] == sizes[1] && sizes[1] == sizes[2] ? "ok" : "MISMATCH");
+  vector_free (line);
+  vector_free (out);
+}
+
+/* Queues that take bursts of traffic and then drain back to a few elements:
+   RSS at the peak and in the quiet phase after it, compare `bench` and
+   `bench_shrink`. */
+static void
+bench_bursty (void)
+{
+  enum { QUEUES = 64, BURST = 200000, STEADY = 8, ROUNDS = 10 };
+  VECTOR(int) queues[QUEUES] = { 0 };
+  long peak = 0, quiet = 0, sum = 0;
+  const long before = rss_kib ();
+  const double start = now ();
+  for (int r = 0; r < ROUNDS; ++r)
+    {
+      for (int q = 0; q < QUEUES; ++q)
+        for (int i = 0; i < BURST / 4 * (1 + (q + r) % 4); ++i)
+          vector_push (queues[q], i);
+      if (rss_kib () - before > peak)
+        peak = rss_kib () - before;
+      for (int q = 0; q < QUEUES; ++q)
+        while (vector_size (queues[q]) > STEADY)
+          sum += vector_pop (queues[q]);
+      /* Quiet traffic around the steady size. */
+      for (int i = 0; i < 100000; ++i)
+        {
+          vector_push (queues[i % QUEUES], i);
+          sum += vector_pop (queues[i % QUEUES]);
+        }
+      quiet = rss_kib () - before;
+    }
+  printf ("bursty: %d queues, bursts of up to %d ints: peak %ld KiB, "
+          "quiet %ld KiB RSS, %.3fs",
+          QUEUES, BURST, peak, quiet, now () - start);
+#ifdef VECTOR_AUTO_SHRINK
+  printf (", %zu shrinks", vector_shrink_count ());
+#endif
+  printf (" (%ld)\n", sum);
+  for (int q = 0; q < QUEUES; ++q)
+    vector_free (queues[q]);
+}
+
+static const struct {
+  const char *name;
+  void (*run) (void);
+} benchmarks[] = {
+  { "tiny_vectors", bench_tiny_vectors },
+  { "create_free", bench_create_free },
+  { "pipe", bench_pipe },
+  { "jagged", bench_jagged },
+  { "streaming", bench_streaming },
+  { "merge", bench_merge },
+  { "intersect", bench_intersect },
+  { "topk", bench_topk },
+  { "hash_map", bench_hash_map },
+  { "strings", bench_strings },
+  { "bursty", bench_bursty },
+};
+
+int
+main (int argc, char **argv)
+{
+  const size_t count = sizeof (benchmarks) / sizeof (*benchmarks);
+  for (size_t i = 0; i < count; ++i)
+    {
+      int selected = argc == 1;
+      for (int a = 1; a < argc; ++a)
+        selected |= !strcmp (argv[a], benchmarks[i].name);
+      if (selected)
+        benchmarks[i].run ();
+    }
+}
@@ -0,0 +1,168 @@
+/* Benchmarks of vector.hpp against std::vector, run `./bench_cpp` for all of
+   them or `./bench_cpp NAME...` for some. */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory_resource>
+#include <vector>
+#define VECTOR_IMPLEMENTATION
+#include "vector.hpp"
+
+static double
+now ()
+{
+  using clock = std::chrono::steady_clock;
+  return std::chrono::duration<double> (clock::now ().time_since_epoch ()).count ();
+}
+
+/* Keeps the compiler from dropping computations. */
+static volatile long long sink;
+
+/* The timed functions are not inlined, so neither vector type gets optimized
+   with knowledge of how it was filled. */
+#define NOINLINE __attribute__ ((noinline))
+
+template <class Vector>
+NOINLINE static double
+push_back (int rounds, int count)
+{
+  const double start = now ();
+  for (int r = 0; r < rounds; ++r)
+    {
+      Vector v;
+      for (int i = 0; i < count; ++i)
+        v.push_back (i);
+      sink = sink + v.back ();
+    }
+  return now () - start;
+}
+
+/* Appending to fresh vectors, mostly measures growth. */
+static void
+bench_push_back ()
+{
+  enum { ROUNDS = 20, COUNT = 5000000 };
+  std::printf ("push_back: %d x %d ints\n", ROUNDS, COUNT);
+  std::printf ("  std::vector      %.3fs\n",
+               push_back<std::vector<int>> (ROUNDS, COUNT));
+  std::printf ("  c_vector::vector %.3fs\n",
+               push_back<c_vector::vector<int>> (ROUNDS, COUNT));
+}
+
+template <class Vector>
+NOINLINE static double
+iterate (Vector &v, int rounds)
+{
+  const double start = now ();
+  long long sum = 0;
+  for (int r = 0; r < rounds; ++r)
+    {
+      /* Otherwise the sum could be computed only once. */
+      v[r] = r;
+      for (const int x : v)
+        sum += x;
+    }
+  sink = sum;
+  return now () - start;
+}
+
+static void
+bench_iterate ()
+{
+  enum { ROUNDS = 100, COUNT = 5000000 };
+  std::vector<int> a (COUNT);
+  c_vector::vector<int> b (COUNT);
+  for (int i = 0; i < COUNT; ++i)
+    a[i] = b[i] = i;
+  std::printf ("iterate: %d x %d ints\n", ROUNDS, COUNT);
+  std::printf ("  std::vector      %.3fs\n", iterate (a, ROUNDS));
+  std::printf ("  c_vector::vector %.3fs\n", iterate (b, ROUNDS));
+}
+
+template <class Vector>
+NOINLINE static double
+sort (Vector &v)
+{
+  const double start = now ();
+  std::sort (v.begin (), v.end ());
+  return now () - start;
+}
+
+static void
+bench_sort ()
+{
+  enum { COUNT = 10000000 };
+  std::vector<unsigned> a (COUNT);
+  c_vector::vector<unsigned> b (COUNT);
+  unsigned x = 1;
+  for (int i = 0; i < COUNT; ++i)
+    a[i] = b[i] = x = x * 1664525u + 1013904223u;
+  std::printf ("sort: %d random ints\n", COUNT);
+  std::printf ("  std::vector      %.3fs\n", sort (a));
+  std::printf ("  c_vector::vector %.3fs\n", sort (b));
+  if (!std::equal (a.begin (), a.end (), b.begin ()))
+    std::printf ("  results differ\n");
+}
+
+/* Many short-lived vectors from a monotonic arena. */
+static void
+bench_pmr ()
+{
+  enum { ROUNDS = 200, VECTORS = 1000, COUNT = 100 };
+  double start, pmr_time, vector_time;
+  start = now ();
+  for (int r = 0; r < ROUNDS; ++r)
+    {
+      std::pmr::monotonic_buffer_resource arena;
+      for (int i = 0; i < VECTORS; ++i)
+        {
+          std::pmr::vector<int> v (&arena);
+          for (int j = 0; j < COUNT; ++j)
+            v.push_back (j);
+          sink = sink + v.back ();
+        }
+    }
+  pmr_time = now () - start;
+  start = now ();
+  for (int r = 0; r < ROUNDS; ++r)
+    {
+      std::pmr::monotonic_buffer_resource arena;
+      for (int i = 0; i < VECTORS; ++i)
+        {
+          c_vector::vector<int> v (&arena);
+          for (int j = 0; j < COUNT; ++j)
+            v.push_back (j);
+          sink = sink + v.back ();
+        }
+    }
+  vector_time = now () - start;
+  std::printf ("pmr: %d x %d vectors of %d ints from an arena\n",
+               ROUNDS, VECTORS, COUNT);
+  std::printf ("  std::pmr::vector %.3fs\n", pmr_time);
+  std::printf ("  c_vector::vector %.3fs\n", vector_time);
+}
+
+static const struct
+{
+  const char *name;
+  void (*run) ();
+} benchmarks[] = {
+  { "push_back", bench_push_back },
+  { "iterate", bench_iterate },
+  { "sort", bench_sort },
+  { "pmr", bench_pmr },
+};
+
+int
+main (int argc, char **argv)
+{
+  for (const auto &benchmark : benchmarks)
+    {
+      bool selected = argc == 1;
+      for (int a = 1; a < argc; ++a)
+        selected |= !std::strcmp (argv[a], benchmark.name);
+      if (selected)
+        benchmark.run ();
+    }
+}
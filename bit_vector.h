@@ -0,0 +1,394 @@
+#ifndef BIT_VECTOR_H
+#define BIT_VECTOR_H
+#include "vector.h"
+
+#if defined (__BMI2__)
+#include <immintrin.h>
+#endif
+
+/* A bit vector is a vector of uint64_t words whose header size counts bits
+   instead of words, the capacity still counts words so `vector_capacity` and
+   `vector_free` work as usual. Bits past the size are always zero. Other
+   vector_* functions must not be used on it. */
+#define BIT_VECTOR uint64_t *
+
+/* Optional index for rank and select queries, it must be rebuilt after the
+   bit vector is modified. */
+struct bit_vector_rank {
+  /* Number of set bits before each block of VECTOR_RANK_BLOCK words. */
+  VECTOR(uint64_t) counts;
+};
+
+/* Number of words covered by each entry of a bit_vector_rank. */
+#define VECTOR_RANK_BLOCK 8
+
+/**
+ * Parameters:
+ *    b - bit vector
+ *    i - index of bit
+ *    x - bit value
+ *    n - number of bits
+ *    v - vector
+ *    r - struct bit_vector_rank (not a pointer)
+ */
+
+#define bit_vector__word(i) ((i) >> 6)
+#define bit_vector__bit(i) (UINT64_C(1) << ((i) & 63))
+#define bit_vector__needgrow(b, n)\
+  ((b) == NULL                                                        \
+   || (size_t)vector__size (b) + (size_t)(n) > (size_t)vector__capacity (b) * 64)
+#define bit_vector__maybegrow(b, n)                                    \
+  (bit_vector__needgrow ((b), (n))                                     \
+   ? (*((void **)&(b)) = bit_vector__grow ((b), (n))) : 0)
+
+/* Gets the number of bits in the bit vector. */
+#define bit_vector_size(b)\
+  vector_size (b)
+
+/* Gets the bit at index I. */
+#define bit_vector_get(b, i)\
+  (((b)[bit_vector__word (i)] & bit_vector__bit (i)) != 0)
+
+/* Sets the bit at index I to X. */
+#define bit_vector_set(b, i, x)                         \
+  ((x)                                                  \
+   ? ((b)[bit_vector__word (i)] |= bit_vector__bit (i)) \
+   : ((b)[bit_vector__word (i)] &= ~bit_vector__bit (i)))
+
+/* Appends a bit to the bit vector. */
+#define bit_vector_push(b, x)                         \
+  (bit_vector__maybegrow ((b), 1),                    \
+   ((x) ? ((b)[bit_vector__word (vector__size (b))]   \
+           |= bit_vector__bit (vector__size (b)))     \
+        : 0),                                         \
+   ++vector__size (b))
+
+/* Changes the number of bits to N, new bits are zero. */
+#define bit_vector_resize(b, n)\
+  (*((void **)&(b)) = bit_vector__resize ((b), (n)))
+
+/* Frees the bit vector. */
+#define bit_vector_free(b)\
+  vector_free (b)
+
+/* Counts the set bits. */
+#define bit_vector_count(b)\
+  bit_vector__count ((b))
+
+/* Gets the index of the first set bit at or after I, or the size of the bit
+   vector if there is none. */
+#define bit_vector_next(b, i)\
+  bit_vector__next ((b), (i))
+
+/* Iterate over the indices of the set bits, I receives each index. */
+#define bit_vector_for_each_set(b, i)                        \
+  for (size_t i = bit_vector__next ((b), 0);                 \
+       i < bit_vector_size (b); i = bit_vector__next ((b), i + 1))
+
+/* Word-wise operations, DST is modified in place and keeps its size. Bits
+   missing from a shorter SRC count as 0, so `and` clears the rest of DST
+   (the same rule as bit_vector_compact) and `or` and `xor` keep it. */
+#define bit_vector_and(dst, src)\
+  bit_vector__op ((dst), (src), '&')
+#define bit_vector_or(dst, src)\
+  bit_vector__op ((dst), (src), '|')
+#define bit_vector_xor(dst, src)\
+  bit_vector__op ((dst), (src), '^')
+#define bit_vector_not(b)\
+  bit_vector__op ((b), NULL, '~')
+
+/* Removes all elements from the vector V whose bit in B is not set, keeping
+   the order of the remaining ones. Elements past the end of B are removed. */
+#define bit_vector_compact(v, b)                                            \
+  ((v) == NULL                                                              \
+   ? 0                                                                      \
+   : (vector__size (v) = bit_vector__compact ((void *)(v), sizeof (*(v)),   \
+                                              vector__size (v), (b))))
+
+/* Builds the rank/select index R for the bit vector B. */
+#define bit_vector_rank_build(r, b)\
+  bit_vector__rank_build (&(r), (b))
+
+/* Number of set bits before index I. */
+#define bit_vector_rank(r, b, i)\
+  bit_vector__rank (&(r), (b), (i))
+
+/* Index of the set bit with rank K (counting from 0), or the size of the bit
+   vector if there are not enough set bits. */
+#define bit_vector_select(r, b, k)\
+  bit_vector__select (&(r), (b), (k))
+
+/* Frees the rank/select index. */
+#define bit_vector_rank_free(r)\
+  (vector_free ((r).counts), (r).counts = NULL)
+
+unsigned bit_vector__popcount (uint64_t x);
+unsigned bit_vector__ctz (uint64_t x);
+void* bit_vector__grow (uint64_t *data, size_t n);
+void* bit_vector__resize (uint64_t *data, size_t n);
+size_t bit_vector__count (const uint64_t *data);
+size_t bit_vector__next (const uint64_t *data, size_t i);
+void bit_vector__op (uint64_t *dst, const uint64_t *src, char op);
+size_t bit_vector__compact (void *data, size_t elem_size, size_t size,
+                            const uint64_t *bits);
+void bit_vector__rank_build (struct bit_vector_rank *r, const uint64_t *data);
+size_t bit_vector__rank (const struct bit_vector_rank *r, const uint64_t *data,
+                         size_t i);
+size_t bit_vector__select (const struct bit_vector_rank *r,
+                           const uint64_t *data, size_t k);
+
+#endif /* !BIT_VECTOR_H */
+
+
+
+#ifdef VECTOR_IMPLEMENTATION
+#ifndef VECTOR__BIT_IMPLEMENTED
+#define VECTOR__BIT_IMPLEMENTED
+
+inline unsigned
+bit_vector__popcount (uint64_t x)
+{
+#ifdef __GNUC__
+  return __builtin_popcountll (x);
+#else
+  x = x - ((x >> 1) & UINT64_C(0x5555555555555555));
+  x = (x & UINT64_C(0x3333333333333333)) + ((x >> 2) & UINT64_C(0x3333333333333333));
+  x = (x + (x >> 4)) & UINT64_C(0x0f0f0f0f0f0f0f0f);
+  return (x * UINT64_C(0x0101010101010101)) >> 56;
+#endif
+}
+
+inline unsigned
+bit_vector__ctz (uint64_t x)
+{
+#ifdef __GNUC__
+  return __builtin_ctzll (x);
+#else
+  unsigned n = 0;
+  while (!(x & 1))
+    {
+      ++n;
+      x >>= 1;
+    }
+  return n;
+#endif
+}
+
+/* Mask of the bits of the last word that are inside a bit vector of N bits. */
+#define BIT_VECTOR__TAIL_MASK(n)\
+  ((n) & 63 ? bit_vector__bit (n) - 1 : ~UINT64_C(0))
+
+inline void *
+bit_vector__grow (uint64_t *data, size_t n)
+{
+  const size_t size = vector_size (data);
+  const size_t old_capacity = vector_capacity (data);
+  const size_t needed = (size + n + 63) / 64;
+  const size_t default_growth = data ? old_capacity << 1 : 4;
+  const size_t capacity = default_growth > needed ? default_growth : needed;
+  vector__check_size (size + n);
+  data = (uint64_t *)vector__resize_impl (data, capacity, sizeof (uint64_t));
+  memset (data + old_capacity, 0,
+          (capacity - old_capacity) * sizeof (uint64_t));
+  /* vector__resize_impl clamps the size to the capacity in words. */
+  vector__size (data) = size;
+  return data;
+}
+
+inline void *
+bit_vector__resize (uint64_t *data, size_t n)
+{
+  const size_t size = vector_size (data);
+  size_t i;
+  if (n > size)
+    {
+      bit_vector__maybegrow (data, n - size);
+      vector__size (data) = n;
+    }
+  else if (data)
+    {
+      if (n & 63)
+        data[bit_vector__word (n)] &= BIT_VECTOR__TAIL_MASK (n);
+      for (i = (n + 63) / 64; i < (size + 63) / 64; ++i)
+        data[i] = 0;
+      vector__size (data) = n;
+    }
+  return data;
+}
+
+inline size_t
+bit_vector__count (const uint64_t *data)
+{
+  const size_t words = (vector_size (data) + 63) / 64;
+  size_t i, count = 0;
+  for (i = 0; i < words; ++i)
+    count += bit_vector__popcount (data[i]);
+  return count;
+}
+
+inline size_t
+bit_vector__next (const uint64_t *data, size_t i)
+{
+  const size_t size = vector_size (data);
+  const size_t words = (size + 63) / 64;
+  size_t w = bit_vector__word (i);
+  uint64_t x;
+  if (i >= size)
+    return size;
+  x = data[w] & ~(bit_vector__bit (i) - 1);
+  while (!x)
+    {
+      if (++w == words)
+        return size;
+      x = data[w];
+    }
+  return w * 64 + bit_vector__ctz (x);
+}
+
+inline void
+bit_vector__op (uint64_t *dst, const uint64_t *src, char op)
+{
+  const size_t dst_size = vector_size (dst);
+  const size_t n = (op == '~' || vector_size (src) > dst_size
+                    ? dst_size
+                    : vector_size (src));
+  const size_t words = (n + 63) / 64;
+  /* Bits of the last word that are not combined, all zero for negation and
+     for `and` where they are ANDed with 0. */
+  const uint64_t keep = ((n & 63) && op != '~' && op != '&'
+                         ? dst[words - 1] & ~BIT_VECTOR__TAIL_MASK (n)
+                         : 0);
+  size_t i;
+  switch (op)
+    {
+    case '&':
+      for (i = 0; i < words; ++i)
+        dst[i] &= src[i];
+      break;
+    case '|':
+      for (i = 0; i < words; ++i)
+        dst[i] |= src[i];
+      break;
+    case '^':
+      for (i = 0; i < words; ++i)
+        dst[i] ^= src[i];
+      break;
+    case '~':
+      for (i = 0; i < words; ++i)
+        dst[i] = ~dst[i];
+      break;
+    }
+  if (n & 63)
+    dst[words - 1] = (dst[words - 1] & BIT_VECTOR__TAIL_MASK (n)) | keep;
+  if (op == '&')
+    memset (dst + words, 0,
+            ((dst_size + 63) / 64 - words) * sizeof (uint64_t));
+}
+
+/* Copies element FROM to TO, with fast paths for the common sizes. */
+#define BIT_VECTOR__MOVE(data, elem_size, to, from)                        \
+  switch (elem_size)                                                       \
+    {                                                                      \
+    case 1: ((uint8_t *)(data))[to] = ((uint8_t *)(data))[from]; break;    \
+    case 2: ((uint16_t *)(data))[to] = ((uint16_t *)(data))[from]; break;  \
+    case 4: ((uint32_t *)(data))[to] = ((uint32_t *)(data))[from]; break;  \
+    case 8: ((uint64_t *)(data))[to] = ((uint64_t *)(data))[from]; break;  \
+    default:                                                               \
+      memmove ((char *)(data) + (to) * (elem_size),                        \
+               (char *)(data) + (from) * (elem_size), (elem_size));        \
+    }
+
+inline size_t
+bit_vector__compact (void *data, size_t elem_size, size_t size,
+                     const uint64_t *bits)
+{
+  const size_t n = size < vector_size (bits) ? size : vector_size (bits);
+  const size_t words = (n + 63) / 64;
+  size_t w, out = 0;
+  for (w = 0; w < words; ++w)
+    {
+      uint64_t x = bits[w];
+      if (x == ~UINT64_C(0))
+        {
+          /* Whole word selected, move all 64 elements at once. */
+          if (out != w * 64)
+            memmove ((char *)data + out * elem_size,
+                     (char *)data + w * 64 * elem_size, 64 * elem_size);
+          out += 64;
+          continue;
+        }
+      while (x)
+        {
+          const size_t i = w * 64 + bit_vector__ctz (x);
+          BIT_VECTOR__MOVE (data, elem_size, out, i);
+          ++out;
+          x &= x - 1;
+        }
+    }
+  return out;
+}
+
+inline void
+bit_vector__rank_build (struct bit_vector_rank *r, const uint64_t *data)
+{
+  const size_t words = (vector_size (data) + 63) / 64;
+  size_t i, count = 0;
+  vector_clear (r->counts);
+  vector_reserve (r->counts, words / VECTOR_RANK_BLOCK + 1);
+  for (i = 0; i < words; ++i)
+    {
+      if (i % VECTOR_RANK_BLOCK == 0)
+        vector_push (r->counts, count);
+      count += bit_vector__popcount (data[i]);
+    }
+  /* Sentinel with the total count, simplifies select. */
+  vector_push (r->counts, count);
+}
+
+inline size_t
+bit_vector__rank (const struct bit_vector_rank *r, const uint64_t *data,
+                  size_t i)
+{
+  const size_t w = bit_vector__word (i);
+  size_t j, count;
+  if (i >= vector_size (data))
+    return vector_back (r->counts);
+  count = r->counts[w / VECTOR_RANK_BLOCK];
+  for (j = w - w % VECTOR_RANK_BLOCK; j < w; ++j)
+    count += bit_vector__popcount (data[j]);
+  return count + bit_vector__popcount (data[w] & (bit_vector__bit (i) - 1));
+}
+
+inline size_t
+bit_vector__select (const struct bit_vector_rank *r, const uint64_t *data,
+                    size_t k)
+{
+  size_t lo = 0, hi = vector_size (r->counts) - 1, w;
+  uint64_t x;
+  if (k >= vector_back (r->counts))
+    return vector_size (data);
+  /* Last block whose count is <= k. */
+  while (hi - lo > 1)
+    {
+      const size_t mid = lo + (hi - lo) / 2;
+      if (r->counts[mid] <= k)
+        lo = mid;
+      else
+        hi = mid;
+    }
+  k -= r->counts[lo];
+  w = lo * VECTOR_RANK_BLOCK;
+  while (bit_vector__popcount (data[w]) <= k)
+    k -= bit_vector__popcount (data[w++]);
+  x = data[w];
+#if defined (__BMI2__)
+  x = _pdep_u64 (UINT64_C(1) << k, x);
+#else
+  while (k--)
+    x &= x - 1;
+#endif
+  return w * 64 + bit_vector__ctz (x);
+}
+
+#endif /* VECTOR__BIT_IMPLEMENTED */
+#endif /* VECTOR_IMPLEMENTATION */
@@ -0,0 +1,414 @@
+#ifndef HASH_MAP_H
+#define HASH_MAP_H
+#include "vector.h"
+#include <stdint.h>
+
+/* A hash map is a pointer to its entries, which are structs with (at least)
+   a `key` and a `value` member:
+     struct { int key; float value; } *m = NULL;
+   The entries are stored densely in insertion order (until elements are
+   deleted) like a vector, so `hm_size`, `m[i]` and `hm_for_each` walk
+   contiguous memory. In front of the vector header is a second header with
+   the hash index: open addressing with Swiss table style control bytes,
+   probed 16 at a time (with SSE2 where available).
+
+   Keys are hashed and compared as raw bytes, so they must not contain
+   padding or pointers to the actual key (e.g. strings). vector_* functions
+   that allocate or free must not be used on a hash map, use hm_free. */
+
+/**
+ * Parameters:
+ *    m - hash map
+ *    k - key
+ *    v - value
+ *   it - name of the iteration variable
+ */
+
+/* Inserts or overwrites the value for K. */
+#define hm_put(m, k, v)                                                       \
+  (*((void **)&(m)) = hash_map__reserve ((m), sizeof (*(m))),                \
+   (m)[vector__size (m)].key = (k),                                           \
+   (m)[hash_map__insert ((m), sizeof (*(m)), HASH_MAP__KEY (m))].value = (v))
+
+/* Gets a pointer to the entry for K or NULL if there is none. The pointer is
+   invalidated by hm_put and hm_del. */
+#define hm_get(m, k)                                                          \
+  ((m) ? ((m)[vector__size (m)].key = (k),                                    \
+          (VECTOR__DECLTYPE (m))hash_map__find ((m), sizeof (*(m)),           \
+                                                HASH_MAP__KEY (m)))           \
+       : NULL)
+
+/* Gets the index of the entry for K or -1 if there is none. */
+#define hm_geti(m, k)                                                         \
+  ((m) ? ((m)[vector__size (m)].key = (k),                                    \
+          hash_map__find_index ((m), sizeof (*(m)), HASH_MAP__KEY (m)))       \
+       : (ptrdiff_t)-1)
+
+/* Removes the entry for K, the last entry is moved into its place. Returns
+   whether there was an entry for K. */
+#define hm_del(m, k)                                                          \
+  ((m) ? ((m)[vector__size (m)].key = (k),                                    \
+          hash_map__del ((m), sizeof (*(m)), HASH_MAP__KEY (m)))              \
+       : 0)
+
+/* Gets the number of entries. */
+#define hm_size(m)\
+  vector_size (m)
+
+/* Iterate over the entries, IT receives a pointer to each entry. */
+#define hm_for_each(m, it)\
+  vector_for_each (m, it)
+
+/* Removes all entries, keeping the allocated memory. */
+#define hm_clear(m)\
+  hash_map__clear (m)
+
+/* Frees the hash map and sets it to NULL. */
+#define hm_free(m)\
+  (hash_map__free ((m), sizeof (*(m))), (m) = NULL)
+
+/* Offset and size of the key in an entry. */
+#define HASH_MAP__KEY(m)\
+  (size_t)((char *)&(m)->key - (char *)(m)), sizeof ((m)->key)
+
+struct hash_map__header {
+  /* Control byte of each bucket: HASH_MAP__EMPTY, HASH_MAP__DELETED or the
+     low 7 bits of the hash of the key in it. */
+  uint8_t *ctrl;
+  /* Index of the entry in each bucket, in the same allocation as CTRL. */
+  VECTOR__SIZE_T *slots;
+  /* Number of buckets, a power of 2 and at least HASH_MAP__GROUP. */
+  size_t buckets;
+  /* Number of HASH_MAP__DELETED buckets. */
+  size_t tombstones;
+  /* Number of empty buckets that can still be used before the load factor
+     of 7/8 is reached. */
+  size_t growth_left;
+  /* Keeps the entries aligned like vector data. */
+  size_t padding;
+};
+
+#define HASH_MAP__GROUP 16
+#define HASH_MAP__EMPTY 0x80
+#define HASH_MAP__DELETED 0xfe
+
+#define hash_map__get(m)\
+  (((struct hash_map__header *)vector__get (m)) - 1)
+
+void *hash_map__reserve (void *m, size_t elem_size);
+size_t hash_map__insert (void *m, size_t elem_size, size_t key_offset,
+                         size_t key_size);
+void *hash_map__find (void *m, size_t elem_size, size_t key_offset,
+                      size_t key_size);
+ptrdiff_t hash_map__find_index (void *m, size_t elem_size, size_t key_offset,
+                                size_t key_size);
+int hash_map__del (void *m, size_t elem_size, size_t key_offset,
+                   size_t key_size);
+void hash_map__clear (void *m);
+void hash_map__free (void *m, size_t elem_size);
+
+#endif /* !HASH_MAP_H */
+
+
+
+#ifdef VECTOR_IMPLEMENTATION
+#ifndef VECTOR__HASH_MAP_IMPLEMENTED
+#define VECTOR__HASH_MAP_IMPLEMENTED
+
+#if defined (__SSE2__)
+#include <emmintrin.h>
+#endif
+
+static uint64_t
+hash_map__hash (const void *key, size_t n)
+{
+  const unsigned char *p = (const unsigned char *)key;
+  uint64_t h = n * UINT64_C(0x9e3779b97f4a7c15), w;
+  for (; n >= 8; n -= 8, p += 8)
+    {
+      memcpy (&w, p, 8);
+      h = (h ^ w) * UINT64_C(0xff51afd7ed558ccd);
+      h ^= h >> 32;
+    }
+  if (n)
+    {
+      w = 0;
+      memcpy (&w, p, n);
+      h = (h ^ w) * UINT64_C(0xff51afd7ed558ccd);
+    }
+  h ^= h >> 33;
+  h *= UINT64_C(0xc4ceb9fe1a85ec53);
+  h ^= h >> 33;
+  return h;
+}
+
+/* Bit I is set if control byte I of the group is B. */
+static unsigned
+hash_map__match (const uint8_t *group, uint8_t b)
+{
+#if defined (__SSE2__)
+  const __m128i g = _mm_loadu_si128 ((const __m128i *)group);
+  return _mm_movemask_epi8 (_mm_cmpeq_epi8 (g, _mm_set1_epi8 ((char)b)));
+#else
+  unsigned mask = 0, i;
+  for (i = 0; i < HASH_MAP__GROUP; ++i)
+    mask |= (unsigned)(group[i] == b) << i;
+  return mask;
+#endif
+}
+
+/* Bit I is set if bucket I of the group is empty or deleted. */
+static unsigned
+hash_map__match_free (const uint8_t *group)
+{
+#if defined (__SSE2__)
+  return _mm_movemask_epi8 (_mm_loadu_si128 ((const __m128i *)group));
+#else
+  unsigned mask = 0, i;
+  for (i = 0; i < HASH_MAP__GROUP; ++i)
+    mask |= (unsigned)(group[i] >> 7) << i;
+  return mask;
+#endif
+}
+
+static unsigned
+hash_map__ctz (unsigned x)
+{
+#ifdef __GNUC__
+  return __builtin_ctz (x);
+#else
+  unsigned n = 0;
+  while (!(x & 1))
+    {
+      ++n;
+      x >>= 1;
+    }
+  return n;
+#endif
+}
+
+/* Looks up the key pointed to by KEY, returns the index of its entry and
+   stores its bucket in *BUCKET, or returns -1. Groups are probed
+   triangularly, which visits every group since their number is a power of
+   2. A group with an empty bucket ends the probe sequence. */
+static ptrdiff_t
+hash_map__lookup (const void *m, size_t elem_size, size_t key_offset,
+                  size_t key_size, const void *key, uint64_t hash,
+                  size_t *bucket)
+{
+  const struct hash_map__header *h = hash_map__get (m);
+  const size_t groups = h->buckets / HASH_MAP__GROUP;
+  size_t g = (hash >> 7) & (groups - 1), step = 0;
+  if (!h->buckets)
+    return -1;
+  for (;;)
+    {
+      const uint8_t *group = h->ctrl + g * HASH_MAP__GROUP;
+      unsigned match = hash_map__match (group, hash & 0x7f);
+      while (match)
+        {
+          const size_t b = g * HASH_MAP__GROUP + hash_map__ctz (match);
+          const size_t i = h->slots[b];
+          if (!memcmp ((const char *)m + i * elem_size + key_offset, key,
+                       key_size))
+            {
+              *bucket = b;
+              return i;
+            }
+          match &= match - 1;
+        }
+      if (hash_map__match (group, HASH_MAP__EMPTY) || ++step == groups)
+        return -1;
+      g = (g + step) & (groups - 1);
+    }
+}
+
+/* Finds a bucket for a key that is not in the map yet. */
+static size_t
+hash_map__free_bucket (const struct hash_map__header *h, uint64_t hash)
+{
+  const size_t groups = h->buckets / HASH_MAP__GROUP;
+  size_t g = (hash >> 7) & (groups - 1), step = 0;
+  unsigned mask;
+  while (!(mask = hash_map__match_free (h->ctrl + g * HASH_MAP__GROUP)))
+    g = (g + ++step) & (groups - 1);
+  return g * HASH_MAP__GROUP + hash_map__ctz (mask);
+}
+
+/* Builds a new index for the entries with at most 7/16 of the buckets used,
+   which also drops all tombstones. */
+static void
+hash_map__rehash (void *m, size_t elem_size, size_t key_offset,
+                  size_t key_size)
+{
+  struct hash_map__header *h = hash_map__get (m);
+  const size_t size = vector__size (m);
+  size_t buckets = HASH_MAP__GROUP, i;
+  char *index;
+  while (buckets * 7 / 16 < size + 1)
+    buckets *= 2;
+  if (h->ctrl)
+    VECTOR_FREE (h->ctrl, h->buckets * (1 + sizeof (VECTOR__SIZE_T)));
+  index = (char *)VECTOR_MALLOC (buckets * (1 + sizeof (VECTOR__SIZE_T)));
+  if (!index)
+    {
+      fputs ("hash_map__rehash: allocation failed\n", stderr);
+      exit (1);
+    }
+  h->ctrl = (uint8_t *)index;
+  h->slots = (VECTOR__SIZE_T *)(index + buckets);
+  h->buckets = buckets;
+  h->tombstones = 0;
+  h->growth_left = buckets * 7 / 8 - size;
+  memset (h->ctrl, HASH_MAP__EMPTY, buckets);
+  for (i = 0; i < size; ++i)
+    {
+      const char *key = (const char *)m + i * elem_size + key_offset;
+      const uint64_t hash = hash_map__hash (key, key_size);
+      const size_t b = hash_map__free_bucket (h, hash);
+      h->ctrl[b] = hash & 0x7f;
+      h->slots[b] = i;
+    }
+}
+
+inline void *
+hash_map__reserve (void *m, size_t elem_size)
+{
+  const size_t header = sizeof (struct hash_map__header)
+                        + sizeof (struct vector__header);
+  size_t capacity = m ? vector__capacity (m) : 0;
+  char *block;
+  /* Keeps room for one entry past the end where the macros put the key. */
+  if (m && vector__size (m) + 2 <= capacity)
+    return m;
+  capacity = capacity ? capacity * 2 : 8;
+  vector__check_size (capacity);
+  block = (char *)VECTOR_REALLOC (
+    m ? (char *)hash_map__get (m) : NULL,
+    m ? vector__capacity (m) * elem_size + header : 0,
+    capacity * elem_size + header);
+  if (!block)
+    {
+      fputs ("hash_map__reserve: allocation failed\n", stderr);
+      exit (1);
+    }
+  if (!m)
+    memset (block, 0, header);
+  m = block + header;
+  vector__capacity (m) = capacity;
+  return m;
+}
+
+inline size_t
+hash_map__insert (void *m, size_t elem_size, size_t key_offset,
+                  size_t key_size)
+{
+  struct hash_map__header *h = hash_map__get (m);
+  const size_t size = vector__size (m);
+  const char *key = (const char *)m + size * elem_size + key_offset;
+  const uint64_t hash = hash_map__hash (key, key_size);
+  size_t b;
+  const ptrdiff_t i = hash_map__lookup (m, elem_size, key_offset, key_size,
+                                        key, hash, &b);
+  if (i >= 0)
+    return i;
+  if (!h->growth_left)
+    hash_map__rehash (m, elem_size, key_offset, key_size);
+  b = hash_map__free_bucket (h, hash);
+  if (h->ctrl[b] == HASH_MAP__DELETED)
+    --h->tombstones;
+  else
+    --h->growth_left;
+  h->ctrl[b] = hash & 0x7f;
+  h->slots[b] = size;
+  /* The key is already in place. */
+  ++vector__size (m);
+  return size;
+}
+
+inline ptrdiff_t
+hash_map__find_index (void *m, size_t elem_size, size_t key_offset,
+                      size_t key_size)
+{
+  const char *key = (const char *)m + vector__size (m) * elem_size + key_offset;
+  size_t b;
+  return hash_map__lookup (m, elem_size, key_offset, key_size, key,
+                           hash_map__hash (key, key_size), &b);
+}
+
+inline void *
+hash_map__find (void *m, size_t elem_size, size_t key_offset, size_t key_size)
+{
+  const ptrdiff_t i = hash_map__find_index (m, elem_size, key_offset,
+                                            key_size);
+  return i < 0 ? NULL : (char *)m + i * elem_size;
+}
+
+inline int
+hash_map__del (void *m, size_t elem_size, size_t key_offset, size_t key_size)
+{
+  struct hash_map__header *h = hash_map__get (m);
+  const size_t last = vector__size (m) - 1;
+  const char *key = (const char *)m + (last + 1) * elem_size + key_offset;
+  size_t b, group;
+  const ptrdiff_t i = hash_map__lookup (m, elem_size, key_offset, key_size,
+                                        key, hash_map__hash (key, key_size),
+                                        &b);
+  if (i < 0)
+    return 0;
+  /* A group that was never full has an empty bucket, no probe sequence
+     continues past it so the bucket can be empty again too. */
+  group = b & ~(size_t)(HASH_MAP__GROUP - 1);
+  if (hash_map__match (h->ctrl + group, HASH_MAP__EMPTY))
+    {
+      h->ctrl[b] = HASH_MAP__EMPTY;
+      ++h->growth_left;
+    }
+  else
+    {
+      h->ctrl[b] = HASH_MAP__DELETED;
+      ++h->tombstones;
+    }
+  if ((size_t)i != last)
+    {
+      char *moved = (char *)m + last * elem_size;
+      hash_map__lookup (m, elem_size, key_offset, key_size, moved + key_offset,
+                        hash_map__hash (moved + key_offset, key_size), &b);
+      h->slots[b] = i;
+      memcpy ((char *)m + i * elem_size, moved, elem_size);
+    }
+  --vector__size (m);
+  return 1;
+}
+
+inline void
+hash_map__clear (void *m)
+{
+  struct hash_map__header *h;
+  if (!m)
+    return;
+  h = hash_map__get (m);
+  if (h->ctrl)
+    memset (h->ctrl, HASH_MAP__EMPTY, h->buckets);
+  h->tombstones = 0;
+  h->growth_left = h->buckets * 7 / 8;
+  vector__size (m) = 0;
+}
+
+inline void
+hash_map__free (void *m, size_t elem_size)
+{
+  struct hash_map__header *h;
+  (void)elem_size;
+  if (!m)
+    return;
+  h = hash_map__get (m);
+  if (h->ctrl)
+    VECTOR_FREE (h->ctrl, h->buckets * (1 + sizeof (VECTOR__SIZE_T)));
+  VECTOR_FREE (h, vector__capacity (m) * elem_size
+                  + sizeof (struct hash_map__header)
+                  + sizeof (struct vector__header));
+}
+
+#endif /* VECTOR__HASH_MAP_IMPLEMENTED */
+#endif /* VECTOR_IMPLEMENTATION */
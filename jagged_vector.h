@@ -0,0 +1,154 @@
+#ifndef JAGGED_VECTOR_H
+#define JAGGED_VECTOR_H
+#include "vector.h"
+
+/* A jagged vector stores rows of different lengths in compressed sparse row
+   layout: the elements of all rows one after another in a single vector, plus
+   a vector with the offset of each row into it. Compared to VECTOR(VECTOR(T))
+   this needs 2 allocations in total instead of one per row and iterating
+   over all elements walks contiguous memory.
+
+   A zero-initialized jagged vector is empty:
+     JAGGED_VECTOR(int) j = {0};
+   The struct is anonymous, so use a typedef to pass it around. */
+#define JAGGED_VECTOR(T)                                        \
+  struct {                                                      \
+    /* Elements of all rows. */                                 \
+    VECTOR(T) data;                                             \
+    /* Row I is `data[offsets[I]:offsets[I+1]]`, empty until    \
+       the first row is added. */                               \
+    VECTOR(size_t) offsets;                                     \
+  }
+
+/**
+ * Parameters:
+ *    j - jagged vector (not a pointer)
+ *    i - index of row
+ *    e - element
+ *    p - pointer to a buffer of elements
+ *    n - number of elements
+ *   it - name of the iteration variable
+ */
+
+/* Gets the number of rows. */
+#define jagged_vector_rows(j)                           \
+  (vector_size ((j).offsets) ? vector__size ((j).offsets) - 1 : 0)
+
+/* Gets the total number of elements in all rows. */
+#define jagged_vector_size(j)\
+  vector_size ((j).data)
+
+/* Gets a pointer to the first element of row I. */
+#define jagged_vector_row(j, i)\
+  ((j).data + (j).offsets[(i)])
+
+/* Gets the number of elements in row I. */
+#define jagged_vector_row_size(j, i)\
+  ((j).offsets[(i) + 1] - (j).offsets[(i)])
+
+/* Appends a row with the first N elements from the buffer pointed to by P. */
+#define jagged_vector_push_row(j, p, n)                                   \
+  jagged_vector__push_row ((void **)&(j).data, &(j).offsets, (p), (n),    \
+                           sizeof (*(j).data))
+
+/* Appends an empty row, elements can then be added to it with
+   jagged_vector_push. */
+#define jagged_vector_new_row(j)\
+  jagged_vector__push_row ((void **)&(j).data, &(j).offsets, NULL, 0, 0)
+
+/* Appends an element to the last row. */
+#define jagged_vector_push(j, e)\
+  (vector_push ((j).data, (e)), ++vector_back ((j).offsets))
+
+/* Replaces the contents with the rows of the vector of vectors NESTED. The
+   storage is reserved once from the sum of the row sizes. */
+#define jagged_vector_from_nested(j, nested)                              \
+  jagged_vector__from_nested ((void **)&(j).data, &(j).offsets,           \
+                              (void *const *)(nested), vector_size (nested), \
+                              sizeof (**(nested)))
+
+/* Removes all rows. */
+#define jagged_vector_clear(j)\
+  (vector_clear ((j).data), vector_clear ((j).offsets))
+
+/* Frees the jagged vector and makes it empty. */
+#define jagged_vector_free(j)\
+  (vector_free ((j).data), vector_free ((j).offsets), (j).data = NULL, (j).offsets = NULL)
+
+/* Iterate over the rows, I receives the index of each row. */
+#define jagged_vector_for_each_row(j, i)\
+  for (size_t i = 0, vector__rows = jagged_vector_rows (j); i < vector__rows; ++i)
+
+#ifdef VECTOR__DECLTYPE
+/* Iterate over row I, IT receives a pointer to each element. */
+#define jagged_vector_for_each_in_row(j, i, it)                              \
+  for (VECTOR__DECLTYPE ((j).data) it = jagged_vector_row ((j), (i)),        \
+         vector__end = it + jagged_vector_row_size ((j), (i));               \
+       it != vector__end; ++it)
+#endif
+
+void jagged_vector__push_row (void **data, size_t **offsets, const void *p,
+                              size_t n, size_t elem_size);
+void jagged_vector__from_nested (void **data, size_t **offsets,
+                                 void *const *rows, size_t count,
+                                 size_t elem_size);
+
+#endif /* !JAGGED_VECTOR_H */
+
+
+
+#ifdef VECTOR_IMPLEMENTATION
+#ifndef VECTOR__JAGGED_IMPLEMENTED
+#define VECTOR__JAGGED_IMPLEMENTED
+
+inline void
+jagged_vector__push_row (void **data, size_t **offsets, const void *p,
+                         size_t n, size_t elem_size)
+{
+  if (vector_empty (*offsets))
+    vector_push (*offsets, 0);
+  if (n)
+    {
+      if (vector__needgrow (*data, n))
+        *data = vector__grow_impl (*data, n, elem_size);
+      memcpy ((char *)*data + vector__size (*data) * elem_size, p,
+              n * elem_size);
+      vector__size (*data) += n;
+    }
+  vector_push (*offsets, vector_size (*data));
+}
+
+inline void
+jagged_vector__from_nested (void **data, size_t **offsets, void *const *rows,
+                            size_t count, size_t elem_size)
+{
+  size_t i, total = 0, offset = 0;
+  char *w;
+  for (i = 0; i < count; ++i)
+    total += vector_size (rows[i]);
+  /* Not vector_clear, which takes the element size from the type of the
+     pointer, and there's no point in shrinking what gets refilled anyway. */
+  if (*data)
+    vector__size (*data) = 0;
+  if (*offsets)
+    vector__size (*offsets) = 0;
+  if (total > vector_capacity (*data))
+    *data = vector__resize_impl (*data, total, elem_size);
+  vector_reserve (*offsets, count + 1);
+  vector_push (*offsets, 0);
+  w = (char *)*data;
+  for (i = 0; i < count; ++i)
+    {
+      const size_t n = vector_size (rows[i]);
+      if (n)
+        memcpy (w, rows[i], n * elem_size);
+      w += n * elem_size;
+      offset += n;
+      vector_push (*offsets, offset);
+    }
+  if (*data)
+    vector__size (*data) = total;
+}
+
+#endif /* VECTOR__JAGGED_IMPLEMENTED */
+#endif /* VECTOR_IMPLEMENTATION */
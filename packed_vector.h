@@ -0,0 +1,567 @@
+#ifndef PACKED_VECTOR_H
+#define PACKED_VECTOR_H
+#include "vector.h"
+
+#if defined (__AVX2__)
+#include <immintrin.h>
+#endif
+
+/* Compressed vectors of unsigned 64-bit integers.
+
+   packed_vector - every value is stored as `value - base` in WIDTH bits
+                   (frame of reference). Random access is O(1).
+   delta_vector  - values are stored in blocks of VECTOR_DELTA_BLOCK, each
+                   block keeps its first value and bit-packs the (zigzag
+                   encoded) differences between neighbours. Good for sorted
+                   ids. Random access decodes at most one block.
+   varint_vector - differences between neighbours are stored as LEB128
+                   varints, with a block index every VECTOR_DELTA_BLOCK values
+                   for random access. Good for very skewed value sizes.
+
+   All of them may be zero-initialized to get an empty vector. */
+
+/* Number of values per block of delta_vector and varint_vector. */
+#define VECTOR_DELTA_BLOCK 128
+
+struct packed_vector {
+  /* Bit stream, always followed by one spare zero word. */
+  VECTOR(uint64_t) words;
+  size_t size;
+  uint64_t base;
+  /* Largest value stored so far, the encoding covers BASE to at least MAX. */
+  uint64_t max;
+  unsigned width;
+};
+
+struct delta_vector__block {
+  uint64_t first;
+  size_t bit;
+  unsigned width;
+};
+
+struct delta_vector {
+  VECTOR(uint64_t) words;
+  VECTOR(struct delta_vector__block) blocks;
+  size_t bits;
+  size_t size;
+  /* Values of the last block, which is only packed once it is full. */
+  uint64_t tail[VECTOR_DELTA_BLOCK];
+};
+
+struct varint_vector__block {
+  /* Value before the first value of the block. */
+  uint64_t prev;
+  size_t offset;
+};
+
+struct varint_vector {
+  VECTOR(uint8_t) bytes;
+  VECTOR(struct varint_vector__block) blocks;
+  size_t size;
+  uint64_t last;
+};
+
+/**
+ * Parameters:
+ *   pv - packed_vector, delta_vector or varint_vector (not a pointer)
+ *    x - value
+ *    i - index of value
+ *    p - pointer to a buffer of uint64_t
+ *    n - number of values
+ *  dst - VECTOR(uint64_t)
+ */
+
+/* Gets the number of values in the vector. */
+#define packed_vector_size(pv)\
+  ((pv).size)
+
+/* Gets the value at index I, there is no bounds checking. */
+#define packed_vector_get(pv, i)\
+  packed_vector__get (&(pv), (i))
+
+/* Sets the value at index I, repacking the vector if X does not fit. */
+#define packed_vector_set(pv, i, x)\
+  packed_vector__set (&(pv), (i), (x))
+
+/* Appends a value, repacking the vector if X does not fit. */
+#define packed_vector_push(pv, x)\
+  packed_vector__push (&(pv), (x))
+
+/* Replaces the contents with the N values pointed to by P, using the smallest
+   base and width that fit all of them. */
+#define packed_vector_from(pv, p, n)\
+  packed_vector__from (&(pv), (p), (n))
+
+/* Appends all values to the vector DST. */
+#define packed_vector_decode(pv, dst)\
+  (*((void **)&(dst)) = packed_vector__decode (&(pv), (dst)))
+
+/* Number of bytes used by the vector (excluding the struct itself). */
+#define packed_vector_bytes(pv)\
+  (vector_capacity ((pv).words) * sizeof (uint64_t))
+
+/* Frees the vector and makes it empty. */
+#define packed_vector_free(pv)\
+  (vector_free ((pv).words), memset (&(pv), 0, sizeof (pv)))
+
+#define delta_vector_size(pv)\
+  ((pv).size)
+
+#define delta_vector_get(pv, i)\
+  delta_vector__get (&(pv), (i))
+
+#define delta_vector_push(pv, x)\
+  delta_vector__push (&(pv), (x))
+
+#define delta_vector_decode(pv, dst)\
+  (*((void **)&(dst)) = delta_vector__decode (&(pv), (dst)))
+
+#define delta_vector_bytes(pv)                                           \
+  (vector_capacity ((pv).words) * sizeof (uint64_t)                      \
+   + vector_capacity ((pv).blocks) * sizeof (struct delta_vector__block))
+
+#define delta_vector_free(pv)\
+  (vector_free ((pv).words), vector_free ((pv).blocks), memset (&(pv), 0, sizeof (pv)))
+
+#define varint_vector_size(pv)\
+  ((pv).size)
+
+#define varint_vector_get(pv, i)\
+  varint_vector__get (&(pv), (i))
+
+#define varint_vector_push(pv, x)\
+  varint_vector__push (&(pv), (x))
+
+#define varint_vector_decode(pv, dst)\
+  (*((void **)&(dst)) = varint_vector__decode (&(pv), (dst)))
+
+#define varint_vector_bytes(pv)                                           \
+  (vector_capacity ((pv).bytes)                                           \
+   + vector_capacity ((pv).blocks) * sizeof (struct varint_vector__block))
+
+#define varint_vector_free(pv)\
+  (vector_free ((pv).bytes), vector_free ((pv).blocks), memset (&(pv), 0, sizeof (pv)))
+
+unsigned packed_vector__bits (uint64_t x);
+void packed_vector__write (VECTOR(uint64_t) *words, size_t bit, unsigned width,
+                           uint64_t x);
+uint64_t packed_vector__read (const uint64_t *words, size_t bit, unsigned width);
+void packed_vector__unpack (const uint64_t *words, size_t bit, unsigned width,
+                            uint64_t base, size_t n, uint64_t *out);
+uint64_t packed_vector__get (const struct packed_vector *pv, size_t i);
+void packed_vector__set (struct packed_vector *pv, size_t i, uint64_t x);
+void packed_vector__push (struct packed_vector *pv, uint64_t x);
+void packed_vector__from (struct packed_vector *pv, const uint64_t *p, size_t n);
+void* packed_vector__decode (const struct packed_vector *pv, uint64_t *dst);
+uint64_t delta_vector__get (const struct delta_vector *pv, size_t i);
+void delta_vector__push (struct delta_vector *pv, uint64_t x);
+void* delta_vector__decode (const struct delta_vector *pv, uint64_t *dst);
+uint64_t varint_vector__get (const struct varint_vector *pv, size_t i);
+void varint_vector__push (struct varint_vector *pv, uint64_t x);
+void* varint_vector__decode (const struct varint_vector *pv, uint64_t *dst);
+
+#endif /* !PACKED_VECTOR_H */
+
+
+
+#ifdef VECTOR_IMPLEMENTATION
+#ifndef VECTOR__PACKED_IMPLEMENTED
+#define VECTOR__PACKED_IMPLEMENTED
+
+#define PACKED_VECTOR__MASK(width)\
+  ((width) >= 64 ? ~UINT64_C(0) : (UINT64_C(1) << (width)) - 1)
+
+#define PACKED_VECTOR__ZIGZAG(d)\
+  (((d) << 1) ^ (UINT64_C(0) - ((d) >> 63)))
+
+#define PACKED_VECTOR__UNZIGZAG(z)\
+  (((z) >> 1) ^ (UINT64_C(0) - ((z) & 1)))
+
+inline unsigned
+packed_vector__bits (uint64_t x)
+{
+#ifdef __GNUC__
+  return x ? 64 - __builtin_clzll (x) : 0;
+#else
+  unsigned n = 0;
+  while (x)
+    {
+      ++n;
+      x >>= 1;
+    }
+  return n;
+#endif
+}
+
+inline void
+packed_vector__write (VECTOR(uint64_t) *words, size_t bit, unsigned width,
+                      uint64_t x)
+{
+  /* One spare word so readers may always load the word after the last one. */
+  const size_t needed = (bit + width + 63) / 64 + 1;
+  const size_t i = bit >> 6;
+  const unsigned shift = bit & 63;
+  const uint64_t mask = PACKED_VECTOR__MASK (width);
+  if (width == 0)
+    return;
+  if (vector_size (*words) < needed)
+    {
+      const size_t old = vector_size (*words);
+      const size_t capacity = vector_capacity (*words);
+      if (needed > capacity)
+        vector_resize (*words, needed > 2 * capacity ? needed : 2 * capacity);
+      memset (*words + old, 0, (needed - old) * sizeof (uint64_t));
+      vector__size (*words) = needed;
+    }
+  x &= mask;
+  (*words)[i] = ((*words)[i] & ~(mask << shift)) | (x << shift);
+  if (shift + width > 64)
+    (*words)[i + 1] = (((*words)[i + 1] & ~(mask >> (64 - shift)))
+                       | (x >> (64 - shift)));
+}
+
+inline uint64_t
+packed_vector__read (const uint64_t *words, size_t bit, unsigned width)
+{
+  const size_t i = bit >> 6;
+  const unsigned shift = bit & 63;
+  uint64_t x;
+  if (width == 0)
+    return 0;
+  x = words[i] >> shift;
+  if (shift + width > 64)
+    x |= words[i + 1] << (64 - shift);
+  return x & PACKED_VECTOR__MASK (width);
+}
+
+inline void
+packed_vector__unpack (const uint64_t *words, size_t bit, unsigned width,
+                       uint64_t base, size_t n, uint64_t *out)
+{
+  size_t i = 0;
+  if (width == 0)
+    {
+      for (; i < n; ++i)
+        out[i] = base;
+      return;
+    }
+#if defined (__AVX2__)
+  /* Every value starts within the byte at `bit / 8`, so an unaligned 64-bit
+     load from there holds the whole value as long as `7 + width <= 64`. The
+     spare word at the end keeps the last load inside the buffer. */
+  if (width <= 57)
+    {
+      const __m256i mask = _mm256_set1_epi64x ((long long)PACKED_VECTOR__MASK (width));
+      const __m256i vbase = _mm256_set1_epi64x ((long long)base);
+      const __m256i seven = _mm256_set1_epi64x (7);
+      const __m256i step = _mm256_set_epi64x (3 * (long long)width,
+                                              2 * (long long)width,
+                                              (long long)width, 0);
+      const __m256i advance = _mm256_set1_epi64x (4 * (long long)width);
+      __m256i bits = _mm256_add_epi64 (_mm256_set1_epi64x ((long long)bit), step);
+      for (; i + 4 <= n; i += 4)
+        {
+          const __m256i offset = _mm256_srli_epi64 (bits, 3);
+          const __m256i shift = _mm256_and_si256 (bits, seven);
+          __m256i x = _mm256_i64gather_epi64 ((const long long *)(const void *)words,
+                                              offset, 1);
+          x = _mm256_and_si256 (_mm256_srlv_epi64 (x, shift), mask);
+          _mm256_storeu_si256 ((__m256i *)(void *)(out + i),
+                               _mm256_add_epi64 (x, vbase));
+          bits = _mm256_add_epi64 (bits, advance);
+        }
+    }
+#endif
+  for (; i < n; ++i)
+    out[i] = base + packed_vector__read (words, bit + i * width, width);
+}
+
+inline uint64_t
+packed_vector__get (const struct packed_vector *pv, size_t i)
+{
+  return pv->base + packed_vector__read (pv->words, i * pv->width, pv->width);
+}
+
+/* Re-encodes all values with a new base and width. */
+static void
+packed_vector__repack (struct packed_vector *pv, uint64_t base, unsigned width)
+{
+  VECTOR(uint64_t) words = NULL;
+  size_t i;
+  for (i = 0; i < pv->size; ++i)
+    packed_vector__write (&words, i * width, width,
+                          packed_vector__get (pv, i) - base);
+  vector_free (pv->words);
+  pv->words = words;
+  pv->base = base;
+  pv->width = width;
+}
+
+/* Makes sure X can be represented. The width is the one needed for the range
+   of the values. A lowered base goes as far down as that width allows, so
+   the next repack below it widens the vector and it is repacked at most
+   about 128 times. With 64 bits every value fits modulo 2^64, whatever the
+   base is. */
+static void
+packed_vector__fit (struct packed_vector *pv, uint64_t x)
+{
+  uint64_t base = pv->base;
+  const uint64_t max = x > pv->max ? x : pv->max;
+  unsigned width;
+  if (pv->size == 0 && pv->width == 0)
+    {
+      pv->base = pv->max = x;
+      return;
+    }
+  if (pv->width == 64
+      || (x >= base && x - base <= PACKED_VECTOR__MASK (pv->width)))
+    {
+      pv->max = max;
+      return;
+    }
+  if (x < base)
+    {
+      width = packed_vector__bits (max - x);
+      if (width < pv->width)
+        width = pv->width;
+      base = (max > PACKED_VECTOR__MASK (width)
+              ? max - PACKED_VECTOR__MASK (width) : 0);
+    }
+  else
+    width = packed_vector__bits (max - base);
+  packed_vector__repack (pv, base, width);
+  pv->max = max;
+}
+
+inline void
+packed_vector__set (struct packed_vector *pv, size_t i, uint64_t x)
+{
+  packed_vector__fit (pv, x);
+  packed_vector__write (&pv->words, i * pv->width, pv->width, x - pv->base);
+}
+
+inline void
+packed_vector__push (struct packed_vector *pv, uint64_t x)
+{
+  packed_vector__fit (pv, x);
+  packed_vector__write (&pv->words, pv->size * pv->width, pv->width,
+                        x - pv->base);
+  ++pv->size;
+}
+
+inline void
+packed_vector__from (struct packed_vector *pv, const uint64_t *p, size_t n)
+{
+  uint64_t min = n ? p[0] : 0, max = min;
+  size_t i;
+  for (i = 1; i < n; ++i)
+    {
+      if (p[i] < min)
+        min = p[i];
+      if (p[i] > max)
+        max = p[i];
+    }
+  vector_clear (pv->words);
+  pv->base = min;
+  pv->max = max;
+  pv->width = packed_vector__bits (max - min);
+  pv->size = n;
+  if (pv->width)
+    vector_reserve (pv->words, (n * pv->width + 63) / 64 + 1);
+  for (i = 0; i < n; ++i)
+    packed_vector__write (&pv->words, i * pv->width, pv->width, p[i] - min);
+}
+
+inline void *
+packed_vector__decode (const struct packed_vector *pv, uint64_t *dst)
+{
+  vector_reserve (dst, vector_size (dst) + pv->size);
+  if (pv->size)
+    {
+      packed_vector__unpack (pv->words, 0, pv->width, pv->base, pv->size,
+                             dst + vector__size (dst));
+      vector__size (dst) += pv->size;
+    }
+  return dst;
+}
+
+/* Decodes the I-th block of a delta_vector into OUT (VECTOR_DELTA_BLOCK
+   values). */
+static void
+delta_vector__decode_block (const struct delta_vector *pv, size_t i,
+                            uint64_t *out)
+{
+  const struct delta_vector__block *b = pv->blocks + i;
+  size_t j;
+  packed_vector__unpack (pv->words, b->bit, b->width, 0,
+                         VECTOR_DELTA_BLOCK - 1, out + 1);
+  out[0] = b->first;
+  for (j = 1; j < VECTOR_DELTA_BLOCK; ++j)
+    out[j] = out[j - 1] + PACKED_VECTOR__UNZIGZAG (out[j]);
+}
+
+inline uint64_t
+delta_vector__get (const struct delta_vector *pv, size_t i)
+{
+  const size_t block = i / VECTOR_DELTA_BLOCK;
+  const size_t j = i % VECTOR_DELTA_BLOCK;
+  const struct delta_vector__block *b;
+  uint64_t x;
+  size_t k;
+  if (block == vector_size (pv->blocks))
+    return pv->tail[j];
+  b = pv->blocks + block;
+  x = b->first;
+  for (k = 0; k < j; ++k)
+    {
+      const uint64_t z = packed_vector__read (pv->words, b->bit + k * b->width,
+                                              b->width);
+      x += PACKED_VECTOR__UNZIGZAG (z);
+    }
+  return x;
+}
+
+inline void
+delta_vector__push (struct delta_vector *pv, uint64_t x)
+{
+  struct delta_vector__block b;
+  uint64_t deltas[VECTOR_DELTA_BLOCK - 1], all = 0;
+  size_t j;
+  pv->tail[pv->size++ % VECTOR_DELTA_BLOCK] = x;
+  if (pv->size % VECTOR_DELTA_BLOCK)
+    return;
+  for (j = 1; j < VECTOR_DELTA_BLOCK; ++j)
+    {
+      const uint64_t d = pv->tail[j] - pv->tail[j - 1];
+      deltas[j - 1] = PACKED_VECTOR__ZIGZAG (d);
+      all |= deltas[j - 1];
+    }
+  b.first = pv->tail[0];
+  b.bit = pv->bits;
+  b.width = packed_vector__bits (all);
+  for (j = 0; j < VECTOR_DELTA_BLOCK - 1; ++j)
+    packed_vector__write (&pv->words, pv->bits + j * b.width, b.width,
+                          deltas[j]);
+  pv->bits += (VECTOR_DELTA_BLOCK - 1) * b.width;
+  vector_push (pv->blocks, b);
+}
+
+inline void *
+delta_vector__decode (const struct delta_vector *pv, uint64_t *dst)
+{
+  const size_t blocks = vector_size (pv->blocks);
+  size_t i;
+  vector_reserve (dst, vector_size (dst) + pv->size);
+  for (i = 0; i < blocks; ++i)
+    {
+      delta_vector__decode_block (pv, i, dst + vector__size (dst));
+      vector__size (dst) += VECTOR_DELTA_BLOCK;
+    }
+  if (pv->size % VECTOR_DELTA_BLOCK)
+    {
+      memcpy (dst + vector__size (dst), pv->tail,
+              (pv->size % VECTOR_DELTA_BLOCK) * sizeof (uint64_t));
+      vector__size (dst) += pv->size % VECTOR_DELTA_BLOCK;
+    }
+  return dst;
+}
+
+/* Decodes one varint at *P and advances it. */
+static uint64_t
+varint_vector__read (const uint8_t **p)
+{
+  uint64_t x = 0;
+  unsigned shift = 0;
+  const uint8_t *r = *p;
+  while (*r & 0x80)
+    {
+      x |= (uint64_t)(*r++ & 0x7f) << shift;
+      shift += 7;
+    }
+  x |= (uint64_t)*r++ << shift;
+  *p = r;
+  return x;
+}
+
+inline uint64_t
+varint_vector__get (const struct varint_vector *pv, size_t i)
+{
+  const struct varint_vector__block *b = pv->blocks + i / VECTOR_DELTA_BLOCK;
+  const uint8_t *p = pv->bytes + b->offset;
+  uint64_t x = b->prev;
+  size_t j;
+  for (j = 0; j <= i % VECTOR_DELTA_BLOCK; ++j)
+    {
+      const uint64_t z = varint_vector__read (&p);
+      x += PACKED_VECTOR__UNZIGZAG (z);
+    }
+  return x;
+}
+
+inline void
+varint_vector__push (struct varint_vector *pv, uint64_t x)
+{
+  const uint64_t d = x - pv->last;
+  uint64_t z = PACKED_VECTOR__ZIGZAG (d);
+  uint8_t *w;
+  if (pv->size % VECTOR_DELTA_BLOCK == 0)
+    {
+      struct varint_vector__block b;
+      b.prev = pv->last;
+      b.offset = vector_size (pv->bytes);
+      vector_push (pv->blocks, b);
+    }
+  vector__maybegrow (pv->bytes, 10);
+  w = pv->bytes + vector__size (pv->bytes);
+  while (z >= 0x80)
+    {
+      *w++ = (uint8_t)(z | 0x80);
+      z >>= 7;
+    }
+  *w++ = (uint8_t)z;
+  vector__size (pv->bytes) = w - pv->bytes;
+  pv->last = x;
+  ++pv->size;
+}
+
+inline void *
+varint_vector__decode (const struct varint_vector *pv, uint64_t *dst)
+{
+  const uint8_t *p = pv->bytes;
+  const uint8_t *const end = vector_end (pv->bytes);
+  uint64_t x = 0, *w;
+  size_t left = pv->size;
+  vector_reserve (dst, vector_size (dst) + pv->size);
+  w = dst + vector_size (dst);
+  while (left)
+    {
+      uint64_t chunk;
+      /* Fast path for runs of 8 single byte varints. */
+      if (left >= 8 && end - p >= 8
+          && (memcpy (&chunk, p, 8), (chunk & UINT64_C(0x8080808080808080)) == 0))
+        {
+          int k;
+          for (k = 0; k < 8; ++k)
+            {
+              const uint64_t z = p[k];
+              x += PACKED_VECTOR__UNZIGZAG (z);
+              *w++ = x;
+            }
+          p += 8;
+          left -= 8;
+        }
+      else
+        {
+          const uint64_t z = varint_vector__read (&p);
+          x += PACKED_VECTOR__UNZIGZAG (z);
+          *w++ = x;
+          --left;
+        }
+    }
+  if (dst)
+    vector__size (dst) += pv->size;
+  return dst;
+}
+
+#endif /* VECTOR__PACKED_IMPLEMENTED */
+#endif /* VECTOR_IMPLEMENTATION */
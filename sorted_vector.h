@@ -0,0 +1,758 @@
+#ifndef SORTED_VECTOR_H
+#define SORTED_VECTOR_H
+#include "vector.h"
+#include <stdint.h>
+
+#if defined (__AVX__)
+#include <immintrin.h>
+#elif defined (__SSE4_1__)
+#include <smmintrin.h>
+#endif
+
+/* Algorithms on vectors, CMP is a comparison function like for `qsort`:
+   `int cmp (const void *a, const void *b)`. There are two groups:
+
+   - merging and set operations on vectors sorted in ascending order. They
+     append to DST, which is reserved once for the largest possible output
+     before anything is written. DST must not be one of the inputs.
+   - selection of the smallest or largest elements of unsorted vectors.
+     vector_nth_element and vector_partial_sort rearrange V in place, the
+     top-k functions append to DST or keep a heap. */
+
+/**
+ * Parameters:
+ *    dst - destination vector
+ *   srcs - array of K vectors
+ *      k - number of vectors in SRCS
+ *    a,b - vectors
+ *    cmp - comparison function
+ */
+
+/* Merges K sorted vectors into DST using a loser tree, so each element takes
+   log2(K) comparisons. Equal elements keep the order of their vectors. */
+#define vector_merge(dst, srcs, k, cmp)                                       \
+  (*((void **)&(dst)) = vector__merge ((dst), (void *const *)(srcs), (k),     \
+                                       sizeof (*(dst)), (cmp)))
+
+/* Appends the union of A and B to DST. Elements that appear in both are
+   copied once from A, like `std::set_union`. */
+#define vector_union(dst, a, b, cmp)                                          \
+  (*((void **)&(dst)) = vector__set_op ((dst), (a), vector_size (a), (b),     \
+                                        vector_size (b), sizeof (*(dst)),     \
+                                        (cmp), VECTOR__UNION))
+
+/* Appends the elements of A that are also in B to DST. */
+#define vector_intersection(dst, a, b, cmp)                                   \
+  (*((void **)&(dst)) = vector__set_op ((dst), (a), vector_size (a), (b),     \
+                                        vector_size (b), sizeof (*(dst)),     \
+                                        (cmp), VECTOR__INTERSECTION))
+
+/* Appends the elements of A that are not in B to DST. */
+#define vector_difference(dst, a, b, cmp)                                     \
+  (*((void **)&(dst)) = vector__set_op ((dst), (a), vector_size (a), (b),     \
+                                        vector_size (b), sizeof (*(dst)),     \
+                                        (cmp), VECTOR__DIFFERENCE))
+
+/* Intersections of integer vectors without duplicates. If one vector is much
+   smaller its elements are looked up in the other one with galloping search,
+   otherwise blocks of both are compared with SIMD where available (SSE2 for
+   32-bit, SSE4.1 for 64-bit integers). */
+#define vector_intersection_i32(dst, a, b)                                    \
+  (*((void **)&(dst)) = vector__intersection_i32 ((dst), (a), vector_size (a), \
+                                                  (b), vector_size (b)))
+#define vector_intersection_u32(dst, a, b)                                    \
+  (*((void **)&(dst)) = vector__intersection_u32 ((dst), (a), vector_size (a), \
+                                                  (b), vector_size (b)))
+#define vector_intersection_i64(dst, a, b)                                    \
+  (*((void **)&(dst)) = vector__intersection_i64 ((dst), (a), vector_size (a), \
+                                                  (b), vector_size (b)))
+#define vector_intersection_u64(dst, a, b)                                    \
+  (*((void **)&(dst)) = vector__intersection_u64 ((dst), (a), vector_size (a), \
+                                                  (b), vector_size (b)))
+
+/* The smaller vector is searched in the larger one if it has less than
+   1/VECTOR_GALLOP_RATIO of its elements. */
+#ifndef VECTOR_GALLOP_RATIO
+#define VECTOR_GALLOP_RATIO 32
+#endif
+
+enum vector__set_op_kind
+{
+  VECTOR__UNION,
+  VECTOR__INTERSECTION,
+  VECTOR__DIFFERENCE
+};
+
+typedef int (*vector__cmp_fn) (const void *, const void *);
+
+void *vector__merge (void *dst, void *const *srcs, size_t k, size_t elem_size,
+                     vector__cmp_fn cmp);
+void *vector__set_op (void *dst, const void *a, size_t na, const void *b,
+                      size_t nb, size_t elem_size, vector__cmp_fn cmp,
+                      enum vector__set_op_kind kind);
+
+#define VECTOR__SORTED_INT_TYPES(X)             \
+  X (i32, int32_t, 32)                          \
+  X (u32, uint32_t, 32)                         \
+  X (i64, int64_t, 64)                          \
+  X (u64, uint64_t, 64)
+
+#define VECTOR__DECLARE_INTERSECTION(name, T, bits)                     \
+  void *vector__intersection_##name (void *dst, const T *a, size_t na,  \
+                                     const T *b, size_t nb);
+VECTOR__SORTED_INT_TYPES (VECTOR__DECLARE_INTERSECTION)
+
+/* Selection, for getting the smallest or largest elements of V without
+   sorting all of it. V doesn't need to be sorted for these.
+
+   Parameters:
+      v - vector
+      n - index or number of elements
+      k - number of elements
+   heap - vector used as a heap
+      x - element */
+
+/* Rearranges V so that the element at index N is the one that would be there
+   if V were sorted, with no greater element before it and no smaller one
+   after it. Uses quickselect with a median of three pivot, ranges that take
+   too many rounds are sorted with qsort instead. */
+#define vector_nth_element(v, n, cmp)                                         \
+  vector__nth_element ((v), vector_size (v), (n), sizeof (*(v)), (cmp))
+
+/* Sorts the N smallest elements of V into its first N positions, the order of
+   the others is unspecified. */
+#define vector_partial_sort(v, n, cmp)                                        \
+  vector__partial_sort ((v), vector_size (v), (n), sizeof (*(v)), (cmp))
+
+/* Appends the K largest elements of V to DST, in descending order. They are
+   collected in a min-heap in the spare capacity of DST, so most elements only
+   take a single comparison with the smallest one so far. */
+#define vector_topk(dst, v, k, cmp)                                           \
+  (*((void **)&(dst)) = vector__topk ((dst), (v), vector_size (v), (k),       \
+                                      sizeof (*(dst)), (cmp)))
+
+/* Streaming version of vector_topk: HEAP keeps the K largest elements pushed
+   so far as a min-heap, with the smallest one at HEAP[0]. If HEAP is full X
+   replaces the smallest element if it's greater. */
+#define vector_topk_push(heap, k, x, cmp)                                     \
+  (vector__maybegrow ((heap), 1), (heap)[vector__size (heap)] = (x),          \
+   vector__topk_push ((heap), (k), sizeof (*(heap)), (cmp)))
+
+/* Sorts HEAP in descending order, after which it is no longer a heap. */
+#define vector_topk_sort(heap, cmp)                                           \
+  vector__topk_sort ((heap), vector_size (heap), sizeof (*(heap)), (cmp))
+
+/* vector_topk for float and int32_t. Blocks of V are compared against the
+   smallest element in the heap with SIMD (SSE2 or AVX/AVX2 where available),
+   only elements that are greater go into the heap. NaNs are skipped. */
+#define vector_topk_f32(dst, v, k)                                            \
+  (*((void **)&(dst)) = vector__topk_f32 ((dst), (v), vector_size (v), (k)))
+#define vector_topk_i32(dst, v, k)                                            \
+  (*((void **)&(dst)) = vector__topk_i32 ((dst), (v), vector_size (v), (k)))
+
+void vector__nth_element (void *v, size_t size, size_t n, size_t elem_size,
+                          vector__cmp_fn cmp);
+void vector__partial_sort (void *v, size_t size, size_t n, size_t elem_size,
+                           vector__cmp_fn cmp);
+void *vector__topk (void *dst, const void *v, size_t size, size_t k,
+                    size_t elem_size, vector__cmp_fn cmp);
+void vector__topk_push (void *heap, size_t k, size_t elem_size,
+                        vector__cmp_fn cmp);
+void vector__topk_sort (void *heap, size_t size, size_t elem_size,
+                        vector__cmp_fn cmp);
+
+#define VECTOR__TOPK_TYPES(X)                   \
+  X (f32, float)                                \
+  X (i32, int32_t)
+
+#define VECTOR__DECLARE_TOPK(name, T)                                     \
+  void *vector__topk_##name (void *dst, const T *v, size_t size, size_t k);
+VECTOR__TOPK_TYPES (VECTOR__DECLARE_TOPK)
+
+#endif /* !SORTED_VECTOR_H */
+
+
+
+#ifdef VECTOR_IMPLEMENTATION
+#ifndef VECTOR__SORTED_IMPLEMENTED
+#define VECTOR__SORTED_IMPLEMENTED
+
+/* Makes room for N more elements in DST with a single allocation. */
+static void *
+vector__sorted_reserve (void *dst, size_t n, size_t elem_size)
+{
+  const size_t needed = vector_size (dst) + n;
+  if (!n || needed <= vector_capacity (dst))
+    return dst;
+  return vector__resize_impl (dst, needed, elem_size);
+}
+
+struct vector__merge_state
+{
+  void *const *srcs;
+  size_t *pos;
+  size_t elem_size;
+  vector__cmp_fn cmp;
+};
+
+/* Whether the next element of source A goes before the one of source B. An
+   exhausted source loses against everything, ties go to the lower index. */
+static int
+vector__merge_before (const struct vector__merge_state *s, size_t a, size_t b)
+{
+  int c;
+  if (s->pos[a] == vector_size (s->srcs[a]))
+    return 0;
+  if (s->pos[b] == vector_size (s->srcs[b]))
+    return 1;
+  c = s->cmp ((const char *)s->srcs[a] + s->pos[a] * s->elem_size,
+              (const char *)s->srcs[b] + s->pos[b] * s->elem_size);
+  return c < 0 || (c == 0 && a < b);
+}
+
+inline void *
+vector__merge (void *dst, void *const *srcs, size_t k, size_t elem_size,
+               vector__cmp_fn cmp)
+{
+  struct vector__merge_state s;
+  size_t total = 0, i, n;
+  size_t *tree, *win;
+  char *w;
+  for (i = 0; i < k; ++i)
+    total += vector_size (srcs[i]);
+  dst = vector__sorted_reserve (dst, total, elem_size);
+  if (!total)
+    return dst;
+  /* Node N has the children 2N and 2N+1, leaf I is node K+I. tree[N] holds
+     the source that lost at inner node N and tree[0] the overall winner,
+     win is only needed to build it. */
+  s.pos = (size_t *)VECTOR_MALLOC (4 * k * sizeof (size_t));
+  if (!s.pos)
+    {
+      fputs ("vector_merge: allocation failed\n", stderr);
+      exit (1);
+    }
+  tree = s.pos + k;
+  win = tree + k;
+  s.srcs = srcs;
+  s.elem_size = elem_size;
+  s.cmp = cmp;
+  for (i = 0; i < k; ++i)
+    {
+      s.pos[i] = 0;
+      win[k + i] = i;
+    }
+  for (n = k - 1; n >= 1; --n)
+    {
+      const size_t l = win[2 * n], r = win[2 * n + 1];
+      const int left = vector__merge_before (&s, l, r);
+      win[n] = left ? l : r;
+      tree[n] = left ? r : l;
+    }
+  tree[0] = win[1];
+  w = (char *)dst + vector__size (dst) * elem_size;
+  for (i = 0; i < total; ++i)
+    {
+      size_t winner = tree[0];
+      memcpy (w, (const char *)srcs[winner] + s.pos[winner] * elem_size,
+              elem_size);
+      w += elem_size;
+      ++s.pos[winner];
+      /* Replay the path from the leaf of the winner to the root. */
+      for (n = (k + winner) / 2; n >= 1; n /= 2)
+        if (vector__merge_before (&s, tree[n], winner))
+          {
+            const size_t t = tree[n];
+            tree[n] = winner;
+            winner = t;
+          }
+      tree[0] = winner;
+    }
+  vector__size (dst) += total;
+  VECTOR_FREE (s.pos, 4 * k * sizeof (size_t));
+  return dst;
+}
+
+inline void *
+vector__set_op (void *dst, const void *a, size_t na, const void *b,
+                size_t nb, size_t elem_size, vector__cmp_fn cmp,
+                enum vector__set_op_kind kind)
+{
+  const char *pa = (const char *)a, *pb = (const char *)b;
+  const char *const ea = pa + na * elem_size, *const eb = pb + nb * elem_size;
+  const size_t most = (kind == VECTOR__UNION ? na + nb
+                       : kind == VECTOR__DIFFERENCE ? na
+                       : na < nb ? na : nb);
+  char *w;
+  dst = vector__sorted_reserve (dst, most, elem_size);
+  if (!most)
+    return dst;
+  w = (char *)dst + vector__size (dst) * elem_size;
+  while (pa != ea && pb != eb)
+    {
+      const int c = cmp (pa, pb);
+      if (c < 0)
+        {
+          if (kind != VECTOR__INTERSECTION)
+            {
+              memcpy (w, pa, elem_size);
+              w += elem_size;
+            }
+          pa += elem_size;
+        }
+      else if (c > 0)
+        {
+          if (kind == VECTOR__UNION)
+            {
+              memcpy (w, pb, elem_size);
+              w += elem_size;
+            }
+          pb += elem_size;
+        }
+      else
+        {
+          if (kind != VECTOR__DIFFERENCE)
+            {
+              memcpy (w, pa, elem_size);
+              w += elem_size;
+            }
+          pa += elem_size;
+          pb += elem_size;
+        }
+    }
+  if (kind != VECTOR__INTERSECTION && pa != ea)
+    {
+      memcpy (w, pa, ea - pa);
+      w += ea - pa;
+    }
+  if (kind == VECTOR__UNION && pb != eb)
+    {
+      memcpy (w, pb, eb - pb);
+      w += eb - pb;
+    }
+  vector__size (dst) = (w - (char *)dst) / elem_size;
+  return dst;
+}
+
+/* Compares 4x4 elements at once: A against all rotations of B. */
+#if defined (__SSE2__)
+#define VECTOR__INTERSECT_BLOCK_32(T)                                         \
+  while (i + 4 <= na && j + 4 <= nb)                                          \
+    {                                                                         \
+      const __m128i va = _mm_loadu_si128 ((const __m128i *)(a + i));          \
+      const __m128i vb = _mm_loadu_si128 ((const __m128i *)(b + j));          \
+      __m128i m = _mm_cmpeq_epi32 (va, vb);                                   \
+      m = _mm_or_si128 (m, _mm_cmpeq_epi32 (                                  \
+        va, _mm_shuffle_epi32 (vb, _MM_SHUFFLE (0, 3, 2, 1))));               \
+      m = _mm_or_si128 (m, _mm_cmpeq_epi32 (                                  \
+        va, _mm_shuffle_epi32 (vb, _MM_SHUFFLE (1, 0, 3, 2))));               \
+      m = _mm_or_si128 (m, _mm_cmpeq_epi32 (                                  \
+        va, _mm_shuffle_epi32 (vb, _MM_SHUFFLE (2, 1, 0, 3))));               \
+      const int mask = _mm_movemask_ps (_mm_castsi128_ps (m));                \
+      /* Write all 4 and keep the matches, there are at most I matches so  \
+         far so this stays within the reserved NA elements. */                \
+      for (int x = 0; x < 4; ++x)                                             \
+        {                                                                     \
+          out[n] = a[i + x];                                                  \
+          n += mask >> x & 1;                                                 \
+        }                                                                     \
+      const T a_last = a[i + 3], b_last = b[j + 3];                           \
+      i += (a_last <= b_last) * 4;                                            \
+      j += (b_last <= a_last) * 4;                                            \
+    }
+#else
+#define VECTOR__INTERSECT_BLOCK_32(T)
+#endif
+
+/* Same for 2x2 64-bit elements. */
+#if defined (__SSE4_1__)
+#define VECTOR__INTERSECT_BLOCK_64(T)                                         \
+  while (i + 2 <= na && j + 2 <= nb)                                          \
+    {                                                                         \
+      const __m128i va = _mm_loadu_si128 ((const __m128i *)(a + i));          \
+      const __m128i vb = _mm_loadu_si128 ((const __m128i *)(b + j));          \
+      __m128i m = _mm_cmpeq_epi64 (va, vb);                                   \
+      m = _mm_or_si128 (m, _mm_cmpeq_epi64 (                                  \
+        va, _mm_shuffle_epi32 (vb, _MM_SHUFFLE (1, 0, 3, 2))));               \
+      const int mask = _mm_movemask_pd (_mm_castsi128_pd (m));                \
+      out[n] = a[i];                                                          \
+      n += mask & 1;                                                          \
+      out[n] = a[i + 1];                                                      \
+      n += mask >> 1 & 1;                                                     \
+      const T a_last = a[i + 1], b_last = b[j + 1];                           \
+      i += (a_last <= b_last) * 2;                                            \
+      j += (b_last <= a_last) * 2;                                            \
+    }
+#else
+#define VECTOR__INTERSECT_BLOCK_64(T)
+#endif
+
+#define VECTOR__DEFINE_INTERSECTION(name, T, bits)                            \
+  inline void *                                                               \
+  vector__intersection_##name (void *dst, const T *a, size_t na,              \
+                               const T *b, size_t nb)                         \
+  {                                                                           \
+    size_t i = 0, j = 0, n;                                                   \
+    T *out;                                                                   \
+    if (na > nb)                                                              \
+      {                                                                       \
+        const T *const t = a;                                                 \
+        const size_t tn = na;                                                 \
+        a = b;                                                                \
+        na = nb;                                                              \
+        b = t;                                                                \
+        nb = tn;                                                              \
+      }                                                                       \
+    dst = vector__sorted_reserve (dst, na, sizeof (T));                       \
+    if (!na)                                                                  \
+      return dst;                                                             \
+    out = (T *)dst;                                                           \
+    n = vector__size (dst);                                                   \
+    if (na < nb / VECTOR_GALLOP_RATIO)                                        \
+      {                                                                       \
+        for (; i < na && j < nb; ++i)                                         \
+          {                                                                   \
+            /* Find the first element of B that is not less than a[i] by    \
+               doubling the step, then bisecting the last one. */             \
+            size_t step = 1, hi;                                              \
+            while (j + step < nb && b[j + step] < a[i])                       \
+              {                                                               \
+                j += step;                                                    \
+                step *= 2;                                                    \
+              }                                                               \
+            hi = j + step < nb ? j + step : nb;                               \
+            while (j < hi)                                                    \
+              {                                                               \
+                const size_t mid = j + (hi - j) / 2;                          \
+                if (b[mid] < a[i])                                            \
+                  j = mid + 1;                                                \
+                else                                                          \
+                  hi = mid;                                                   \
+              }                                                               \
+            if (j < nb && b[j] == a[i])                                       \
+              out[n++] = b[j++];                                              \
+          }                                                                   \
+      }                                                                       \
+    else                                                                      \
+      {                                                                       \
+        VECTOR__INTERSECT_BLOCK_##bits (T)                                    \
+        while (i < na && j < nb)                                              \
+          {                                                                   \
+            if (a[i] < b[j])                                                  \
+              ++i;                                                            \
+            else if (b[j] < a[i])                                             \
+              ++j;                                                            \
+            else                                                              \
+              {                                                               \
+                out[n++] = a[i];                                              \
+                ++i;                                                          \
+                ++j;                                                          \
+              }                                                               \
+          }                                                                   \
+      }                                                                       \
+    vector__size (dst) = n;                                                   \
+    return dst;                                                               \
+  }
+VECTOR__SORTED_INT_TYPES (VECTOR__DEFINE_INTERSECTION)
+
+/* Swaps the ELEM_SIZE bytes at A and B. */
+static void
+vector__swap_elements (char *a, char *b, size_t elem_size)
+{
+  char t[64];
+  while (elem_size)
+    {
+      const size_t n = elem_size < sizeof (t) ? elem_size : sizeof (t);
+      memcpy (t, a, n);
+      memcpy (a, b, n);
+      memcpy (b, t, n);
+      a += n;
+      b += n;
+      elem_size -= n;
+    }
+}
+
+inline void
+vector__nth_element (void *v, size_t size, size_t n, size_t elem_size,
+                     vector__cmp_fn cmp)
+{
+  char *const base = (char *)v;
+  size_t lo = 0, hi = size - 1, depth = 0, i, j;
+  if (n >= size)
+    return;
+  for (i = size; i > 1; i /= 2)
+    depth += 2;
+  while (hi - lo > 2)
+    {
+      const size_t mid = lo + (hi - lo) / 2;
+      char *const pivot = base + lo * elem_size;
+      if (depth-- == 0)
+        {
+          qsort (pivot, hi - lo + 1, elem_size, cmp);
+          return;
+        }
+      /* Order LO, MID and HI and use the median as pivot at LO. HI is then
+         not less than the pivot, which stops the first scan. */
+      if (cmp (base + mid * elem_size, pivot) < 0)
+        vector__swap_elements (base + mid * elem_size, pivot, elem_size);
+      if (cmp (base + hi * elem_size, base + mid * elem_size) < 0)
+        {
+          vector__swap_elements (base + hi * elem_size,
+                                 base + mid * elem_size, elem_size);
+          if (cmp (base + mid * elem_size, pivot) < 0)
+            vector__swap_elements (base + mid * elem_size, pivot, elem_size);
+        }
+      vector__swap_elements (base + mid * elem_size, pivot, elem_size);
+      /* Both scans stop at elements equal to the pivot, so duplicates are
+         spread evenly. */
+      i = lo;
+      j = hi + 1;
+      for (;;)
+        {
+          do
+            ++i;
+          while (cmp (base + i * elem_size, pivot) < 0);
+          do
+            --j;
+          while (cmp (base + j * elem_size, pivot) > 0);
+          if (i >= j)
+            break;
+          vector__swap_elements (base + i * elem_size, base + j * elem_size,
+                                 elem_size);
+        }
+      vector__swap_elements (pivot, base + j * elem_size, elem_size);
+      if (j == n)
+        return;
+      if (n < j)
+        hi = j - 1;
+      else
+        lo = j + 1;
+    }
+  for (i = lo + 1; i <= hi; ++i)
+    for (j = i; j > lo && cmp (base + (j - 1) * elem_size,
+                               base + j * elem_size) > 0; --j)
+      vector__swap_elements (base + (j - 1) * elem_size, base + j * elem_size,
+                             elem_size);
+}
+
+inline void
+vector__partial_sort (void *v, size_t size, size_t n, size_t elem_size,
+                      vector__cmp_fn cmp)
+{
+  if (n >= size)
+    n = size;
+  else if (n)
+    vector__nth_element (v, size, n - 1, elem_size, cmp);
+  if (n > 1)
+    qsort (v, n, elem_size, cmp);
+}
+
+/* Min-heap helpers, the smallest element by CMP is at H[0]. */
+static void
+vector__heap_sift_up (char *h, size_t i, size_t elem_size, vector__cmp_fn cmp)
+{
+  while (i > 0)
+    {
+      const size_t parent = (i - 1) / 2;
+      if (cmp (h + i * elem_size, h + parent * elem_size) >= 0)
+        break;
+      vector__swap_elements (h + i * elem_size, h + parent * elem_size,
+                             elem_size);
+      i = parent;
+    }
+}
+
+static void
+vector__heap_sift_down (char *h, size_t n, size_t i, size_t elem_size,
+                        vector__cmp_fn cmp)
+{
+  size_t child;
+  while ((child = 2 * i + 1) < n)
+    {
+      if (child + 1 < n
+          && cmp (h + (child + 1) * elem_size, h + child * elem_size) < 0)
+        ++child;
+      if (cmp (h + child * elem_size, h + i * elem_size) >= 0)
+        break;
+      vector__swap_elements (h + i * elem_size, h + child * elem_size,
+                             elem_size);
+      i = child;
+    }
+}
+
+inline void
+vector__topk_sort (void *heap, size_t size, size_t elem_size,
+                   vector__cmp_fn cmp)
+{
+  char *const h = (char *)heap;
+  /* Move the smallest element to the back each time. */
+  while (size > 1)
+    {
+      --size;
+      vector__swap_elements (h, h + size * elem_size, elem_size);
+      vector__heap_sift_down (h, size, 0, elem_size, cmp);
+    }
+}
+
+inline void *
+vector__topk (void *dst, const void *v, size_t size, size_t k,
+              size_t elem_size, vector__cmp_fn cmp)
+{
+  const char *p = (const char *)v;
+  size_t i;
+  char *h;
+  if (k > size)
+    k = size;
+  dst = vector__sorted_reserve (dst, k, elem_size);
+  if (!k)
+    return dst;
+  h = (char *)dst + vector__size (dst) * elem_size;
+  for (i = 0; i < size; ++i, p += elem_size)
+    if (i < k)
+      {
+        memcpy (h + i * elem_size, p, elem_size);
+        vector__heap_sift_up (h, i, elem_size, cmp);
+      }
+    else if (cmp (p, h) > 0)
+      {
+        memcpy (h, p, elem_size);
+        vector__heap_sift_down (h, k, 0, elem_size, cmp);
+      }
+  vector__topk_sort (h, k, elem_size, cmp);
+  vector__size (dst) += k;
+  return dst;
+}
+
+inline void
+vector__topk_push (void *heap, size_t k, size_t elem_size, vector__cmp_fn cmp)
+{
+  char *const h = (char *)heap;
+  const size_t n = vector__size (heap);
+  /* vector_topk_push put the new element behind the last one. */
+  const char *const x = h + n * elem_size;
+  if (n < k)
+    {
+      vector__size (heap) = n + 1;
+      vector__heap_sift_up (h, n, elem_size, cmp);
+    }
+  else if (n && cmp (x, h) > 0)
+    {
+      memcpy (h, x, elem_size);
+      vector__heap_sift_down (h, n, 0, elem_size, cmp);
+    }
+}
+
+/* VECTOR__TOPK_GREATER_name (p, t) gives a bit mask of the
+   VECTOR__TOPK_WIDTH_name elements at P that are greater than T. */
+#if defined (__AVX__)
+#define VECTOR__TOPK_WIDTH_f32 8
+#define VECTOR__TOPK_GREATER_f32(p, t)                                        \
+  _mm256_movemask_ps (_mm256_cmp_ps (_mm256_loadu_ps (p), _mm256_set1_ps (t), \
+                                     _CMP_GT_OQ))
+#elif defined (__SSE2__)
+#define VECTOR__TOPK_WIDTH_f32 4
+#define VECTOR__TOPK_GREATER_f32(p, t)                                        \
+  _mm_movemask_ps (_mm_cmpgt_ps (_mm_loadu_ps (p), _mm_set1_ps (t)))
+#else
+#define VECTOR__TOPK_WIDTH_f32 1
+#define VECTOR__TOPK_GREATER_f32(p, t) (*(p) > (t))
+#endif
+#define VECTOR__TOPK_IS_NAN_f32(x) ((x) != (x))
+
+#if defined (__AVX2__)
+#define VECTOR__TOPK_WIDTH_i32 8
+#define VECTOR__TOPK_GREATER_i32(p, t)                                        \
+  _mm256_movemask_ps (_mm256_castsi256_ps (_mm256_cmpgt_epi32 (               \
+    _mm256_loadu_si256 ((const __m256i *)(p)), _mm256_set1_epi32 (t))))
+#elif defined (__SSE2__)
+#define VECTOR__TOPK_WIDTH_i32 4
+#define VECTOR__TOPK_GREATER_i32(p, t)                                        \
+  _mm_movemask_ps (_mm_castsi128_ps (_mm_cmpgt_epi32 (                        \
+    _mm_loadu_si128 ((const __m128i *)(p)), _mm_set1_epi32 (t))))
+#else
+#define VECTOR__TOPK_WIDTH_i32 1
+#define VECTOR__TOPK_GREATER_i32(p, t) (*(p) > (t))
+#endif
+#define VECTOR__TOPK_IS_NAN_i32(x) 0
+
+#define VECTOR__DEFINE_TOPK(name, T)                                          \
+  /* Puts X at the root of the heap H of N elements and sifts it down. */     \
+  static void                                                                 \
+  vector__topk_sift_down_##name (T *h, size_t n, T x)                         \
+  {                                                                           \
+    size_t i = 0, child;                                                      \
+    while ((child = 2 * i + 1) < n)                                           \
+      {                                                                       \
+        child += child + 1 < n && h[child + 1] < h[child];                    \
+        if (!(h[child] < x))                                                  \
+          break;                                                              \
+        h[i] = h[child];                                                      \
+        i = child;                                                            \
+      }                                                                       \
+    h[i] = x;                                                                 \
+  }                                                                           \
+                                                                              \
+  /* Puts X at index I of the heap H and sifts it up. */                      \
+  static void                                                                 \
+  vector__topk_sift_up_##name (T *h, size_t i, T x)                           \
+  {                                                                           \
+    while (i > 0 && x < h[(i - 1) / 2])                                       \
+      {                                                                       \
+        h[i] = h[(i - 1) / 2];                                                \
+        i = (i - 1) / 2;                                                      \
+      }                                                                       \
+    h[i] = x;                                                                 \
+  }                                                                           \
+                                                                              \
+  inline void *                                                               \
+  vector__topk_##name (void *dst, const T *v, size_t size, size_t k)          \
+  {                                                                           \
+    size_t i = 0, n = 0;                                                      \
+    T *h;                                                                     \
+    if (k > size)                                                             \
+      k = size;                                                               \
+    dst = vector__sorted_reserve (dst, k, sizeof (T));                        \
+    if (!k)                                                                   \
+      return dst;                                                             \
+    h = (T *)dst + vector__size (dst);                                        \
+    for (; i < size && n < k; ++i)                                            \
+      if (!VECTOR__TOPK_IS_NAN_##name (v[i]))                                 \
+        vector__topk_sift_up_##name (h, n++, v[i]);                           \
+    if (n == k)                                                               \
+      {                                                                       \
+        T min = h[0];                                                         \
+        for (; i + VECTOR__TOPK_WIDTH_##name <= size;                         \
+             i += VECTOR__TOPK_WIDTH_##name)                                  \
+          {                                                                   \
+            const int mask = VECTOR__TOPK_GREATER_##name (v + i, min);        \
+            if (!mask)                                                        \
+              continue;                                                       \
+            for (int b = 0; b < VECTOR__TOPK_WIDTH_##name; ++b)               \
+              /* MIN may have grown since the comparison. */                  \
+              if (mask >> b & 1 && v[i + b] > min)                            \
+                {                                                             \
+                  vector__topk_sift_down_##name (h, k, v[i + b]);             \
+                  min = h[0];                                                 \
+                }                                                             \
+          }                                                                   \
+        for (; i < size; ++i)                                                 \
+          if (v[i] > min)                                                     \
+            {                                                                 \
+              vector__topk_sift_down_##name (h, k, v[i]);                     \
+              min = h[0];                                                     \
+            }                                                                 \
+      }                                                                       \
+    /* Sort in descending order by moving the smallest to the back. */        \
+    for (i = n; i > 1;)                                                       \
+      {                                                                       \
+        const T x = h[--i];                                                   \
+        h[i] = h[0];                                                          \
+        vector__topk_sift_down_##name (h, i, x);                              \
+      }                                                                       \
+    vector__size (dst) += n;                                                  \
+    return dst;                                                               \
+  }
+VECTOR__TOPK_TYPES (VECTOR__DEFINE_TOPK)
+
+#endif /* VECTOR__SORTED_IMPLEMENTED */
+#endif /* VECTOR_IMPLEMENTATION */
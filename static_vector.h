@@ -2,6 +2,10 @@
 #define STATIC_VECTOR_H
 #include "vector.h"
 
+#ifdef VECTOR_AUTO_SHRINK
+# error "static vectors can't be shrunk, they don't work with VECTOR_AUTO_SHRINK"
+#endif
+
 /* Number of elements of type T required to hold the header of a vector. */
 #define VECTOR__HEAD_SPACE(T)                                          \
   (sizeof (T) >= sizeof (struct vector__header)                        \
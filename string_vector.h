@@ -0,0 +1,196 @@
+#ifndef STRING_VECTOR_H
+#define STRING_VECTOR_H
+#include "vector.h"
+#include <stdarg.h>
+
+/* String building on VECTOR(char). The functions here write directly into
+   the spare capacity of the vector and keep a NUL terminator after the last
+   character, which is not counted in `vector_size`. vector_cstr can be used
+   to get a terminated string after other vector_* functions modified V. */
+
+/**
+ * Parameters:
+ *    v - VECTOR(char)
+ *    s - null-terminated string
+ *    p - pointer to characters
+ *    n - number of characters
+ *    x - number
+ *  fmt - printf format string
+ *   ap - va_list
+ *  ... - format arguments
+ */
+
+/* Appends formatted text like `printf`. The text is formatted into the spare
+   capacity, only if it doesn't fit the vector grows and it's formatted again. */
+#define vector_appendf(v, ...)\
+  (*((void **)&(v)) = vector__appendf ((v), __VA_ARGS__))
+
+/* Same as vector_appendf but with a va_list. */
+#define vector_vappendf(v, fmt, ap)\
+  (*((void **)&(v)) = vector__vappendf ((v), (fmt), (ap)))
+
+/* Appends the null-terminated string S (without the terminator). */
+#define vector_append_str(v, s)\
+  (*((void **)&(v)) = vector__append_mem ((v), (s), strlen (s)))
+
+/* Appends N characters from P. */
+#define vector_append_mem(v, p, n)\
+  (*((void **)&(v)) = vector__append_mem ((v), (p), (n)))
+
+/* Appends the decimal representation of the signed integer X. */
+#define vector_append_int(v, x)\
+  (*((void **)&(v)) = vector__append_int ((v), (x)))
+
+/* Appends the decimal representation of the unsigned integer X. */
+#define vector_append_uint(v, x)\
+  (*((void **)&(v)) = vector__append_uint ((v), (x)))
+
+/* Appends the floating point number X with up to 17 significant digits, the
+   fewest of 15 or 17 that read back as the same value. */
+#define vector_append_double(v, x)\
+  (*((void **)&(v)) = vector__append_double ((v), (x)))
+
+/* Terminates V and returns it as a `char *`. Makes room for the terminator
+   if needed, an empty vector gets allocated. */
+#define vector_cstr(v)                                                    \
+  (vector__maybegrow ((v), 1), (v)[vector__size (v)] = '\0', (char *)(v))
+
+char *vector__vappendf (char *v, const char *fmt, va_list ap);
+#ifdef __GNUC__
+__attribute__ ((format (printf, 2, 3)))
+#endif
+char *vector__appendf (char *v, const char *fmt, ...);
+char *vector__append_mem (char *v, const void *p, size_t n);
+char *vector__append_int (char *v, long long x);
+char *vector__append_uint (char *v, unsigned long long x);
+char *vector__append_double (char *v, double x);
+
+#endif /* !STRING_VECTOR_H */
+
+
+
+#ifdef VECTOR_IMPLEMENTATION
+#ifndef VECTOR__STRING_IMPLEMENTED
+#define VECTOR__STRING_IMPLEMENTED
+
+inline char *
+vector__vappendf (char *v, const char *fmt, va_list ap)
+{
+  const size_t spare = v ? vector__capacity (v) - vector__size (v) : 0;
+  va_list retry;
+  int n;
+  va_copy (retry, ap);
+  n = vsnprintf (spare ? v + vector__size (v) : NULL, spare, fmt, ap);
+  if (n >= 0)
+    {
+      if ((size_t)n >= spare)
+        {
+          v = (char *)vector__grow_impl (v, n + 1, 1);
+          vsnprintf (v + vector__size (v), n + 1, fmt, retry);
+        }
+      vector__size (v) += n;
+    }
+  va_end (retry);
+  return v;
+}
+
+inline char *
+vector__appendf (char *v, const char *fmt, ...)
+{
+  va_list ap;
+  va_start (ap, fmt);
+  v = vector__vappendf (v, fmt, ap);
+  va_end (ap);
+  return v;
+}
+
+inline char *
+vector__append_mem (char *v, const void *p, size_t n)
+{
+  if (vector__needgrow (v, n + 1))
+    v = (char *)vector__grow_impl (v, n + 1, 1);
+  if (n)
+    memcpy (v + vector__size (v), p, n);
+  vector__size (v) += n;
+  v[vector__size (v)] = '\0';
+  return v;
+}
+
+/* Writes the digits of X, with a '-' in front if NEGATIVE, two at a time from
+   the back. */
+static char *
+vector__append_digits (char *v, unsigned long long x, int negative)
+{
+  static const char pairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536"
+    "37383940414243444546474849505152535455565758596061626364656667686970717273"
+    "7475767778798081828384858687888990919293949596979899";
+  unsigned long long t = x;
+  size_t digits = 1;
+  char *p;
+  while (t >= 100)
+    {
+      digits += 2;
+      t /= 100;
+    }
+  digits += t >= 10;
+  if (vector__needgrow (v, negative + digits + 1))
+    v = (char *)vector__grow_impl (v, negative + digits + 1, 1);
+  p = v + vector__size (v);
+  if (negative)
+    *p++ = '-';
+  vector__size (v) += negative + digits;
+  p += digits;
+  *p = '\0';
+  while (x >= 100)
+    {
+      const unsigned i = (unsigned)(x % 100) * 2;
+      x /= 100;
+      *--p = pairs[i + 1];
+      *--p = pairs[i];
+    }
+  if (x >= 10)
+    {
+      *--p = pairs[x * 2 + 1];
+      *--p = pairs[x * 2];
+    }
+  else
+    *--p = (char)('0' + x);
+  return v;
+}
+
+inline char *
+vector__append_int (char *v, long long x)
+{
+  return x < 0 ? vector__append_digits (v, 0ULL - (unsigned long long)x, 1)
+               : vector__append_digits (v, x, 0);
+}
+
+inline char *
+vector__append_uint (char *v, unsigned long long x)
+{
+  return vector__append_digits (v, x, 0);
+}
+
+inline char *
+vector__append_double (char *v, double x)
+{
+  /* "-1.2345678901234567e-308" plus the terminator. */
+  enum { MAX_LENGTH = 32 };
+  char *p;
+  int n;
+  /* Whole numbers below 1e15 look the same with %.15g, except -0. */
+  if (x > -1e15 && x < 1e15 && x != 0 && x == (double)(long long)x)
+    return vector__append_int (v, (long long)x);
+  if (vector__needgrow (v, MAX_LENGTH))
+    v = (char *)vector__grow_impl (v, MAX_LENGTH, 1);
+  p = v + vector__size (v);
+  n = snprintf (p, MAX_LENGTH, "%.15g", x);
+  if (x == x && strtod (p, NULL) != x)
+    n = snprintf (p, MAX_LENGTH, "%.17g", x);
+  vector__size (v) += n;
+  return v;
+}
+
+#endif /* VECTOR__STRING_IMPLEMENTED */
+#endif /* VECTOR_IMPLEMENTATION */
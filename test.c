@@ -1,10 +1,26 @@
 #include <stdint.h>
 #include <stdarg.h>
+#include <math.h>
 #include "smallunit.h"
 #define VECTOR_IMPLEMENTATION
 #include "vector.h"
+#ifndef VECTOR_AUTO_SHRINK
 #define VECTOR_IMPLEMENTATION
 #include "static_vector.h"
+#endif
+#define VECTOR_IMPLEMENTATION
+#include "packed_vector.h"
+#define VECTOR_IMPLEMENTATION
+#include "bit_vector.h"
+#include "vector_pipe.h"
+#define VECTOR_IMPLEMENTATION
+#include "jagged_vector.h"
+#define VECTOR_IMPLEMENTATION
+#include "sorted_vector.h"
+#define VECTOR_IMPLEMENTATION
+#include "hash_map.h"
+#define VECTOR_IMPLEMENTATION
+#include "string_vector.h"
 
 #ifdef __clang__
 #pragma clang diagnostic ignored "-Wnull-pointer-arithmetic"
@@ -21,6 +37,10 @@ struct MyStruct
   const char *s;
 };
 
+int compare_int(const void *a, const void *b) {
+  return (*(const int *)a > *(const int *)b) - (*(const int *)a < *(const int *)b);
+}
+
 uint32_t next_power_of_2(uint32_t v) {
   --v;
   v |= v >> 1;
@@ -95,6 +115,51 @@ su_module (vector_tests, {
     vector_free (v);
   })
 
+  su_test ("vector_adopt", {
+    VECTOR(int) buf = vector_alloc_buffer (int, 10);
+    for (int i = 0; i < 5; ++i)
+      buf[i] = i;
+    VECTOR(int) v = vector_adopt (buf, 5);
+    su_assert_eq (v, buf);
+    su_assert (check (v, 5, 0, 1, 2, 3, 4));
+    su_assert_eq (vector_capacity (v), 10);
+    vector_free (v);
+
+    int *p = malloc (3 * sizeof (int));
+    p[0] = 7; p[1] = 8; p[2] = 9;
+    VECTOR(int) m = vector_adopt_malloc (p, 3);
+    su_assert (check (m, 3, 7, 8, 9));
+    vector_push (m, 10);
+    su_assert (check (m, 4, 7, 8, 9, 10));
+    vector_free (m);
+  })
+
+  su_test ("vector_release", {
+    VECTOR(int) v = vector_create_from (G_int_buffer, 10);
+    size_t len = 0;
+    int *p = vector_release (v, &len);
+    su_assert_eq (v, NULL);
+    su_assert_eq (len, 10);
+    su_assert (!memcmp (p, G_int_buffer, sizeof (G_int_buffer)));
+    free (p);
+    su_assert_eq (vector_release (v, &len), NULL);
+    su_assert_eq (len, 0);
+  })
+
+  su_test ("vector_swap", {
+    VECTOR(int) a = vector_init (1, 2);
+    VECTOR(int) b = vector_init (3);
+    vector_swap (a, b);
+    su_assert (check (a, 1, 3));
+    su_assert (check (b, 2, 1, 2));
+    vector_move (a, b);
+    su_assert (check (a, 2, 1, 2));
+    su_assert_eq (b, NULL);
+    vector_move (a, a);
+    su_assert (check (a, 2, 1, 2));
+    vector_free (a);
+  })
+
   su_test ("vector_idx", {
     VECTOR(int) v = vector_create_from (G_int_buffer, 10);
     su_assert_eq (vector_idx (v, 0), 0);
@@ -316,6 +381,36 @@ su_module (vector_tests, {
     vector_free (v5);
   })
 
+  su_test ("vector_copy_streaming", {
+    VECTOR(int) src = NULL;
+    VECTOR(int) dst = NULL;
+    VECTOR(int) pushed = vector_init (-1);
+    VECTOR(int) big = NULL;
+    for (int i = 0; i < 1000; ++i)
+      vector_push (src, i);
+    su_assert (vector__streaming_threshold () > 0);
+    vector_copy_streaming (dst, src);
+    su_assert_eq (vector_size (dst), 1000);
+    su_assert (!memcmp (dst, src, 1000 * sizeof (int)));
+    /* Force the streaming path for the implicit copies too, copies below
+       VECTOR_STREAMING_MIN bytes never stream. */
+    for (int i = 0; i < (int)(VECTOR_STREAMING_MIN / sizeof (int)); ++i)
+      vector_push (big, i);
+    vector_set_streaming_threshold (1);
+    vector_push_vector (pushed, big);
+    su_assert_eq (vector_size (pushed), vector_size (big) + 1);
+    su_assert_eq (pushed[0], -1);
+    su_assert (!memcmp (pushed + 1, big, vector_size (big) * sizeof (int)));
+    vector_free (big);
+    vector_erase (src, 10, 990);
+    vector_copy (dst, src);
+    su_assert (check (dst, 10, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9));
+    vector_set_streaming_threshold (0);
+    vector_free (pushed);
+    vector_free (dst);
+    vector_free (src);
+  })
+
   su_test ("vector_for_each",  {
     int *my_vec = vector_init (1, 2, 3, 4, 5);
     int i = 0;
@@ -388,9 +483,89 @@ su_module (vector_tests, {
     su_assert_eq (empty, NULL);
   })
 
+#ifdef VECTOR_CACHE
+  su_test ("vector_cache", {
+    vector_cache_flush ();
+    VECTOR(int) a = vector_create (int, 10);
+    int *const block = (int *)(void *)vector__get (a);
+    vector_free (a);
+    /* Same size class is reused, the capacity is what the block holds. */
+    VECTOR(int) b = vector_create (int, 9);
+    su_assert_eq ((int *)(void *)vector__get (b), block);
+    su_assert_eq (vector_capacity (b), 10);
+    VECTOR(int) c = vector_clone (b);
+    su_assert (c != b);
+    vector_free (b);
+    vector_free (c);
+    /* Blocks that don't hold whole elements are not reused. */
+    vector_cache_flush ();
+    VECTOR(char) e = vector_create (char, 9);
+    char *const odd = (char *)(void *)vector__get (e);
+    vector_free (e);
+    VECTOR(double) f = vector_create (double, 1);
+    su_assert ((char *)(void *)vector__get (f) != odd);
+    vector_free (f);
+    vector_cache_limit (0);
+    VECTOR(int) d = vector_create (int, 10);
+    vector_free (d);
+    vector_cache_limit (VECTOR_CACHE_MAX_BLOCKS);
+    vector_cache_flush ();
+  })
+#endif
+
+#ifdef VECTOR_COMPACT_HEADER
+  su_test ("vector_compact_limit", {
+    /* Only the header is looked at, the sums must not wrap in 32 bits. */
+    struct vector__header h = {UINT32_MAX, UINT32_MAX};
+    int *v = (int *)(void *)h.data;
+    uint64_t *b = (uint64_t *)(void *)h.data;
+    su_assert (vector__needgrow (v, 1));
+    h.size = 3u << 30;
+    su_assert (vector__needgrow (v, 3u << 30));
+    su_assert (!vector__needgrow (v, (1u << 30) - 1));
+    h.size = 0;
+    h.capacity = 1u << 26;
+    su_assert (!bit_vector__needgrow (b, 1));
+    su_assert (bit_vector__needgrow (b, (size_t)1 << 32 | 1));
+  })
+#endif
+
+#ifdef VECTOR_AUTO_SHRINK
+  su_test ("vector_auto_shrink", {
+    VECTOR(int) v = NULL;
+    const size_t shrinks = vector_shrink_count ();
+    for (int i = 0; i < 1000; ++i)
+      vector_push (v, i);
+    su_assert_eq (vector_capacity (v), 1024);
+    /* Halved repeatedly in one step once the size falls below 1/4. */
+    vector_erase (v, 100, 900);
+    su_assert_eq (vector_capacity (v), 256);
+    su_assert_eq (v[99], 99);
+    su_assert_eq (vector_shrink_count (), shrinks + 1);
+    /* Pushing and popping around one size doesn't shrink or grow. */
+    for (int i = 0; i < 100; ++i)
+      {
+        vector_push (v, i);
+        su_assert_eq (vector_pop (v), i);
+      }
+    su_assert_eq (vector_capacity (v), 256);
+    while (vector_size (v) > 1)
+      (void)vector_pop (v);
+    su_assert_eq (vector_pop (v), 0);
+    su_assert_eq (vector_capacity (v), VECTOR_SHRINK_MIN_CAPACITY);
+    vector_resize (v, 100);
+    vector_remove (v, 0);
+    su_assert_eq (vector_capacity (v), 100);
+    vector_clear (v);
+    su_assert_eq (vector_capacity (v), 25);
+    vector_free (v);
+  })
+#endif
+
   vector_free(ivec);
 })
 
+#ifndef VECTOR_AUTO_SHRINK
 su_module (static_vector_tests, {
   su_test ("vector_create_static", {
     int buf[VECTOR_STATIC_SIZE (int, 10)];
@@ -445,8 +620,656 @@ su_module (static_vector_tests, {
   })
 })
 
+#endif
+
+su_module (packed_vector_tests, {
+  su_test ("packed_vector_push", {
+    struct packed_vector pv = {0};
+    for (uint64_t i = 0; i < 1000; ++i)
+      packed_vector_push (pv, 1000 + i * 3);
+    su_assert_eq (packed_vector_size (pv), 1000);
+    su_assert_eq (pv.width, 12);
+    for (size_t i = 0; i < 1000; ++i)
+      su_assert_eq (packed_vector_get (pv, i), 1000 + i * 3);
+    /* Values below the base and above the width get repacked. */
+    packed_vector_push (pv, 5);
+    packed_vector_push (pv, UINT64_MAX);
+    su_assert_eq (packed_vector_get (pv, 0), 1000);
+    su_assert_eq (packed_vector_get (pv, 999), 1000 + 999 * 3);
+    su_assert_eq (packed_vector_get (pv, 1000), 5);
+    su_assert_eq (packed_vector_get (pv, 1001), UINT64_MAX);
+    packed_vector_set (pv, 3, 42);
+    su_assert_eq (packed_vector_get (pv, 3), 42);
+    su_assert_eq (packed_vector_get (pv, 4), 1012);
+    packed_vector_free (pv);
+    su_assert_eq (packed_vector_size (pv), 0);
+    /* The width stays at 64 when the base is lowered again. */
+    packed_vector_push (pv, UINT64_MAX);
+    packed_vector_push (pv, 1);
+    packed_vector_push (pv, 0);
+    su_assert_eq (pv.width, 64);
+    su_assert_eq (packed_vector_get (pv, 0), UINT64_MAX);
+    su_assert_eq (packed_vector_get (pv, 1), 1);
+    su_assert_eq (packed_vector_get (pv, 2), 0);
+    packed_vector_free (pv);
+  })
+
+  su_test ("packed_vector_push_order", {
+    struct packed_vector pv = {0};
+    /* Lowering the base doesn't add a bit for every push. */
+    for (uint64_t i = 1000; i >= 1; --i)
+      packed_vector_push (pv, i);
+    su_assert (pv.width <= 10);
+    for (size_t i = 0; i < 1000; ++i)
+      su_assert_eq (packed_vector_get (pv, i), 1000 - i);
+    packed_vector_free (pv);
+    for (uint64_t i = 0; i < 500; ++i)
+      {
+        packed_vector_push (pv, 500 + i);
+        packed_vector_push (pv, 500 - i);
+      }
+    su_assert (pv.width <= 10);
+    for (size_t i = 0; i < 500; ++i)
+      {
+        su_assert_eq (packed_vector_get (pv, 2 * i), 500 + i);
+        su_assert_eq (packed_vector_get (pv, 2 * i + 1), 500 - i);
+      }
+    packed_vector_free (pv);
+  })
+
+  su_test ("packed_vector_from", {
+    struct packed_vector pv = {0};
+    VECTOR(uint64_t) v = NULL;
+    VECTOR(uint64_t) out = NULL;
+    for (uint64_t i = 0; i < 1001; ++i)
+      vector_push (v, (i * 7919) % 1024 + 500);
+    packed_vector_from (pv, v, vector_size (v));
+    su_assert_eq (pv.base, 500);
+    su_assert_eq (pv.width, 10);
+    su_assert (packed_vector_bytes (pv) * 4 < vector_size (v) * sizeof (uint64_t));
+    vector_push (out, 1);
+    packed_vector_decode (pv, out);
+    su_assert_eq (vector_size (out), 1002);
+    su_assert_eq (out[0], 1);
+    su_assert (!memcmp (out + 1, v, vector_size (v) * sizeof (uint64_t)));
+    vector_free (out);
+    vector_free (v);
+    packed_vector_free (pv);
+  })
+
+  su_test ("delta_vector", {
+    struct delta_vector dv = {0};
+    VECTOR(uint64_t) out = NULL;
+    uint64_t x = 1ull << 40;
+    for (size_t i = 0; i < 1000; ++i)
+      delta_vector_push (dv, x += i % 17);
+    delta_vector_push (dv, 3);
+    su_assert_eq (delta_vector_size (dv), 1001);
+    delta_vector_decode (dv, out);
+    su_assert_eq (vector_size (out), 1001);
+    for (size_t i = 0; i < 1001; ++i)
+      su_assert_eq (delta_vector_get (dv, i), out[i]);
+    su_assert_eq (out[0], 1ull << 40);
+    su_assert_eq (out[1000], 3);
+    su_assert (delta_vector_bytes (dv) * 4 < 1001 * sizeof (uint64_t));
+    vector_free (out);
+    delta_vector_free (dv);
+  })
+
+  su_test ("varint_vector", {
+    struct varint_vector vv = {0};
+    VECTOR(uint64_t) out = NULL;
+    for (uint64_t i = 0; i < 1000; ++i)
+      varint_vector_push (vv, i % 100 == 99 ? UINT64_MAX - i : i);
+    su_assert_eq (varint_vector_size (vv), 1000);
+    varint_vector_decode (vv, out);
+    su_assert_eq (vector_size (out), 1000);
+    for (uint64_t i = 0; i < 1000; ++i)
+      {
+        su_assert_eq (out[i], i % 100 == 99 ? UINT64_MAX - i : i);
+        su_assert_eq (varint_vector_get (vv, i), out[i]);
+      }
+    vector_free (out);
+    varint_vector_free (vv);
+  })
+})
+
+su_module (bit_vector_tests, {
+  su_test ("bit_vector_push", {
+    BIT_VECTOR b = NULL;
+    for (int i = 0; i < 200; ++i)
+      bit_vector_push (b, i % 3 == 0);
+    su_assert_eq (bit_vector_size (b), 200);
+    su_assert_eq (vector_capacity (b), 4);
+    for (int i = 0; i < 200; ++i)
+      su_assert_eq (bit_vector_get (b, i), i % 3 == 0);
+    su_assert_eq (bit_vector_count (b), 67);
+    bit_vector_set (b, 1, 1);
+    bit_vector_set (b, 0, 0);
+    su_assert_eq (bit_vector_get (b, 0), 0);
+    su_assert_eq (bit_vector_get (b, 1), 1);
+    bit_vector_resize (b, 70);
+    su_assert_eq (bit_vector_count (b), 24);
+    bit_vector_resize (b, 300);
+    su_assert_eq (bit_vector_count (b), 24);
+    bit_vector_free (b);
+  })
+
+  su_test ("bit_vector_ops", {
+    BIT_VECTOR a = NULL;
+    BIT_VECTOR b = NULL;
+    for (int i = 0; i < 100; ++i)
+      {
+        bit_vector_push (a, i % 2 == 0);
+        bit_vector_push (b, i % 5 == 0);
+      }
+    bit_vector_and (a, b);
+    su_assert_eq (bit_vector_count (a), 10);
+    bit_vector_or (a, b);
+    su_assert_eq (bit_vector_count (a), 20);
+    bit_vector_xor (a, b);
+    su_assert_eq (bit_vector_count (a), 0);
+    bit_vector_not (a);
+    su_assert_eq (bit_vector_count (a), 100);
+    bit_vector_resize (b, 10);
+    bit_vector_or (a, b);
+    su_assert_eq (bit_vector_count (a), 100);
+    /* Bits past the end of B count as 0. */
+    bit_vector_and (a, b);
+    su_assert_eq (bit_vector_count (a), 2);
+    su_assert_eq (bit_vector_size (a), 100);
+    bit_vector_not (a);
+    bit_vector_xor (a, b);
+    su_assert_eq (bit_vector_count (a), 100);
+    bit_vector_free (a);
+    bit_vector_free (b);
+  })
+
+  su_test ("bit_vector_for_each_set", {
+    BIT_VECTOR b = NULL;
+    VECTOR(int) set = NULL;
+    bit_vector_resize (b, 150);
+    bit_vector_set (b, 3, 1);
+    bit_vector_set (b, 64, 1);
+    bit_vector_set (b, 149, 1);
+    bit_vector_for_each_set (b, i)
+      vector_push (set, (int)i);
+    su_assert (check (set, 3, 3, 64, 149));
+    su_assert_eq (bit_vector_next (b, 65), 149);
+    su_assert_eq (bit_vector_next (b, 150), 150);
+    vector_free (set);
+    bit_vector_free (b);
+  })
+
+  su_test ("bit_vector_rank", {
+    BIT_VECTOR b = NULL;
+    struct bit_vector_rank r = {0};
+    for (int i = 0; i < 2000; ++i)
+      bit_vector_push (b, i % 7 == 0);
+    bit_vector_rank_build (r, b);
+    su_assert_eq (bit_vector_rank (r, b, 0), 0);
+    su_assert_eq (bit_vector_rank (r, b, 1), 1);
+    su_assert_eq (bit_vector_rank (r, b, 700), 100);
+    su_assert_eq (bit_vector_rank (r, b, 5000), 286);
+    for (size_t k = 0; k < 286; ++k)
+      su_assert_eq (bit_vector_select (r, b, k), k * 7);
+    su_assert_eq (bit_vector_select (r, b, 286), 2000);
+    bit_vector_rank_free (r);
+    bit_vector_free (b);
+  })
+
+  su_test ("bit_vector_compact", {
+    VECTOR(int) v = NULL;
+    BIT_VECTOR b = NULL;
+    for (int i = 0; i < 200; ++i)
+      {
+        vector_push (v, i);
+        bit_vector_push (b, i < 64 || i % 50 == 0);
+      }
+    bit_vector_compact (v, b);
+    su_assert_eq (vector_size (v), 66);
+    for (int i = 0; i < 64; ++i)
+      su_assert_eq (v[i], i);
+    su_assert_eq (v[64], 100);
+    su_assert_eq (v[65], 150);
+    vector_free (v);
+    bit_vector_free (b);
+  })
+})
+
+su_module (jagged_vector_tests, {
+  su_test ("jagged_vector_push_row", {
+    JAGGED_VECTOR(int) j = {0};
+    su_assert_eq (jagged_vector_rows (j), 0);
+    jagged_vector_push_row (j, G_int_buffer, 3);
+    jagged_vector_push_row (j, G_int_buffer, 0);
+    jagged_vector_push_row (j, G_int_buffer + 5, 5);
+    jagged_vector_new_row (j);
+    jagged_vector_push (j, 42);
+    jagged_vector_push (j, 43);
+    su_assert_eq (jagged_vector_rows (j), 4);
+    su_assert_eq (jagged_vector_size (j), 10);
+    su_assert_eq (jagged_vector_row_size (j, 0), 3);
+    su_assert_eq (jagged_vector_row_size (j, 1), 0);
+    su_assert_eq (jagged_vector_row_size (j, 2), 5);
+    su_assert_eq (jagged_vector_row_size (j, 3), 2);
+    su_assert_eq (jagged_vector_row (j, 0)[2], 2);
+    su_assert_eq (jagged_vector_row (j, 2)[0], 5);
+    su_assert_eq (jagged_vector_row (j, 3)[1], 43);
+    jagged_vector_clear (j);
+    su_assert_eq (jagged_vector_rows (j), 0);
+    jagged_vector_free (j);
+  })
+
+  su_test ("jagged_vector_from_nested", {
+    VECTOR(VECTOR(int)) nested = NULL;
+    JAGGED_VECTOR(int) j = {0};
+    for (int i = 0; i < 20; ++i)
+      {
+        VECTOR(int) row = NULL;
+        for (int k = 0; k < i % 4; ++k)
+          vector_push (row, i * 10 + k);
+        vector_push (nested, row);
+      }
+    jagged_vector_from_nested (j, nested);
+    su_assert_eq (jagged_vector_rows (j), 20);
+    su_assert_eq (jagged_vector_size (j), 5 * (0 + 1 + 2 + 3));
+    su_assert_eq (vector_capacity (j.data), jagged_vector_size (j));
+    jagged_vector_for_each_row (j, i)
+      {
+        su_assert_eq (jagged_vector_row_size (j, i), vector_size (nested[i]));
+#ifdef VECTOR__DECLTYPE
+        int k = 0;
+        jagged_vector_for_each_in_row (j, i, it)
+          su_assert_eq (*it, nested[i][k++]);
+#endif
+      }
+    vector_for_each (nested, row)
+      vector_free (*row);
+    vector_free (nested);
+    jagged_vector_free (j);
+  })
+
+  su_test ("jagged_vector_reuse", {
+    VECTOR(VECTOR(int)) nested = NULL;
+    VECTOR(int) row = NULL;
+    JAGGED_VECTOR(int) j = {0};
+    for (int i = 0; i < 200; ++i)
+      vector_push (row, i);
+    vector_push (nested, row);
+    jagged_vector_from_nested (j, nested);
+    su_assert_eq (jagged_vector_size (j), 200);
+    vector_erase (nested[0], 20, 180);
+    jagged_vector_from_nested (j, nested);
+    su_assert_eq (jagged_vector_rows (j), 1);
+    su_assert_eq (jagged_vector_size (j), 20);
+    for (int i = 0; i < 20; ++i)
+      su_assert_eq (j.data[i], i);
+    vector_free (nested[0]);
+    vector_free (nested);
+    jagged_vector_free (j);
+  })
+})
+
+su_module (sorted_vector_tests, {
+  su_test ("vector_merge", {
+    VECTOR(int) parts[5] = {
+      vector_init (1, 4, 7, 10), NULL, vector_init (2, 4, 9),
+      vector_init (0), vector_init (3, 5, 6, 11, 12)
+    };
+    VECTOR(int) out = vector_init (-1);
+    vector_merge (out, parts, 5, compare_int);
+    su_assert (check (out, 14, -1, 0, 1, 2, 3, 4, 4, 5, 6, 7, 9, 10, 11, 12));
+    su_assert_eq (vector_capacity (out), 14);
+    vector_clear (out);
+    vector_merge (out, parts + 1, 1, compare_int);
+    su_assert_eq (vector_size (out), 0);
+    vector_free (out);
+    for (int i = 0; i < 5; ++i)
+      vector_free (parts[i]);
+  })
+
+  su_test ("vector_merge_many", {
+    VECTOR(VECTOR(int)) parts = NULL;
+    VECTOR(int) out = NULL;
+    size_t total = 0;
+    for (int k = 0; k < 37; ++k)
+      {
+        VECTOR(int) part = NULL;
+        for (int i = 0; i < k * 3 % 11; ++i)
+          vector_push (part, i * 37 + k);
+        total += vector_size (part);
+        vector_push (parts, part);
+      }
+    vector_merge (out, parts, vector_size (parts), compare_int);
+    su_assert_eq (vector_size (out), total);
+    for (size_t i = 1; i < vector_size (out); ++i)
+      su_assert (out[i - 1] <= out[i]);
+    vector_for_each (parts, part)
+      vector_free (*part);
+    vector_free (parts);
+    vector_free (out);
+  })
+
+  su_test ("vector_set_operations", {
+    VECTOR(int) a = vector_init (1, 2, 2, 4, 6, 8);
+    VECTOR(int) b = vector_init (2, 3, 4, 5, 8, 9);
+    VECTOR(int) out = NULL;
+    vector_union (out, a, b, compare_int);
+    su_assert (check (out, 9, 1, 2, 2, 3, 4, 5, 6, 8, 9));
+    vector_clear (out);
+    vector_intersection (out, a, b, compare_int);
+    su_assert (check (out, 3, 2, 4, 8));
+    vector_clear (out);
+    vector_difference (out, a, b, compare_int);
+    su_assert (check (out, 3, 1, 2, 6));
+    vector_clear (out);
+    vector_difference (out, a, (int *)NULL, compare_int);
+    su_assert (check (out, 6, 1, 2, 2, 4, 6, 8));
+    vector_free (out);
+    vector_free (a);
+    vector_free (b);
+  })
+
+  su_test ("vector_intersection_int", {
+    VECTOR(int32_t) a = NULL;
+    VECTOR(int32_t) b = NULL;
+    VECTOR(int32_t) out = NULL;
+    VECTOR(uint64_t) c = NULL;
+    VECTOR(uint64_t) d = NULL;
+    VECTOR(uint64_t) out64 = NULL;
+    for (int32_t i = -500; i < 500; ++i)
+      {
+        if (i % 3 == 0)
+          vector_push (a, i);
+        if (i % 5 == 0)
+          vector_push (b, i);
+        if (i % 2 == 0)
+          vector_push (c, (uint64_t)i + 1000);
+        if (i % 100 == 0)
+          vector_push (d, (uint64_t)i + 1000);
+      }
+    vector_intersection_i32 (out, a, b);
+    su_assert_eq (vector_size (out), 67);
+    for (size_t i = 0; i < vector_size (out); ++i)
+      su_assert_eq (out[i], -495 + 15 * (int32_t)i);
+    /* Galloping, D is much smaller than C. */
+    vector_intersection_u64 (out64, c, d);
+    su_assert_eq (vector_size (out64), 10);
+    for (size_t i = 0; i < vector_size (out64); ++i)
+      su_assert_eq (out64[i], d[i]);
+    vector_clear (out);
+    vector_intersection_i32 (out, a, (int32_t *)NULL);
+    su_assert_eq (vector_size (out), 0);
+    vector_free (a);
+    vector_free (b);
+    vector_free (c);
+    vector_free (d);
+    vector_free (out);
+    vector_free (out64);
+  })
+
+  su_test ("vector_nth_element", {
+    VECTOR(int) v = NULL;
+    for (int i = 0; i < 1000; ++i)
+      vector_push (v, (i * 7919) % 1000 / 3);
+    vector_nth_element (v, 500, compare_int);
+    su_assert_eq (v[500], 166);
+    for (int i = 0; i < 500; ++i)
+      su_assert (v[i] <= 166);
+    for (int i = 501; i < 1000; ++i)
+      su_assert (v[i] >= 166);
+    vector_partial_sort (v, 10, compare_int);
+    su_assert_eq (v[2], 0);
+    su_assert_eq (v[9], 3);
+    vector_partial_sort (v, 400, compare_int);
+    for (int i = 0; i < 400; ++i)
+      su_assert_eq (v[i], i / 3);
+    vector_nth_element (v, 1000, compare_int);
+    vector_free (v);
+  })
+
+  su_test ("vector_topk", {
+    VECTOR(int) v = NULL;
+    VECTOR(int) out = vector_init (-1);
+    VECTOR(int) heap = NULL;
+    for (int i = 0; i < 1000; ++i)
+      vector_push (v, (i * 7919) % 1000);
+    vector_topk (out, v, 5, compare_int);
+    su_assert (check (out, 6, -1, 999, 998, 997, 996, 995));
+    for (int i = 0; i < 1000; ++i)
+      vector_topk_push (heap, 5, v[i], compare_int);
+    su_assert_eq (vector_size (heap), 5);
+    su_assert_eq (heap[0], 995);
+    vector_topk_sort (heap, compare_int);
+    su_assert (check (heap, 5, 999, 998, 997, 996, 995));
+    vector_clear (out);
+    vector_topk (out, v, 0, compare_int);
+    su_assert_eq (vector_size (out), 0);
+    vector_free (heap);
+    vector_free (out);
+    vector_free (v);
+  })
+
+  su_test ("vector_topk_simd", {
+    VECTOR(float) f = NULL;
+    VECTOR(float) fout = NULL;
+    VECTOR(int32_t) v = NULL;
+    VECTOR(int32_t) out = NULL;
+    for (int i = 0; i < 10000; ++i)
+      {
+        vector_push (f, i % 7 ? (float)((i * 7919) % 10000) : NAN);
+        vector_push (v, (i * 7919) % 10000 - 5000);
+      }
+    /* 9992 and 9991 are NaN. */
+    vector_topk_f32 (fout, f, 8);
+    su_assert_eq (vector_size (fout), 8);
+    su_assert_eq (fout[0], 9999.0f);
+    su_assert_eq (fout[6], 9993.0f);
+    su_assert_eq (fout[7], 9990.0f);
+    vector_topk_i32 (out, v, 100);
+    su_assert_eq (vector_size (out), 100);
+    for (int i = 0; i < 100; ++i)
+      su_assert_eq (out[i], 4999 - i);
+    vector_clear (out);
+    vector_topk_i32 (out, v, 20000);
+    su_assert_eq (vector_size (out), 10000);
+    su_assert_eq (out[9999], -5000);
+    vector_free (f);
+    vector_free (fout);
+    vector_free (v);
+    vector_free (out);
+  })
+})
+
+su_module (hash_map_tests, {
+  su_test ("hm_put_get", {
+    struct { int key; double value; } *m = NULL;
+    su_assert_eq (hm_get (m, 1), NULL);
+    su_assert_eq (hm_geti (m, 1), -1);
+    su_assert_eq (hm_size (m), 0);
+    hm_put (m, 1, 1.5);
+    hm_put (m, -7, 2.5);
+    hm_put (m, 1, 3.5);
+    su_assert_eq (hm_size (m), 2);
+    su_assert_eq (hm_get (m, 1)->value, 3.5);
+    su_assert_eq (hm_get (m, -7)->value, 2.5);
+    su_assert_eq (hm_geti (m, -7), 1);
+    su_assert_eq (hm_get (m, 2), NULL);
+    hm_clear (m);
+    su_assert_eq (hm_size (m), 0);
+    su_assert_eq (hm_get (m, 1), NULL);
+    hm_free (m);
+    su_assert_eq (m, NULL);
+  })
+
+  su_test ("hm_many", {
+    struct { uint64_t key; int value; } *m = NULL;
+    for (int i = 0; i < 10000; ++i)
+      hm_put (m, (uint64_t)i * 1000003, i);
+    su_assert_eq (hm_size (m), 10000);
+    for (int i = 0; i < 10000; ++i)
+      su_assert_eq (hm_get (m, (uint64_t)i * 1000003)->value, i);
+    su_assert_eq (hm_get (m, 1), NULL);
+    int sum = 0;
+    hm_for_each (m, it)
+      sum += it->value;
+    su_assert_eq (sum, 10000 * 9999 / 2);
+    hm_free (m);
+  })
+
+  su_test ("hm_del", {
+    struct { int key; int value; } *m = NULL;
+    su_assert_eq (hm_del (m, 3), 0);
+    for (int round = 0; round < 20; ++round)
+      {
+        for (int i = 0; i < 1000; ++i)
+          hm_put (m, round * 1000 + i, i);
+        /* Delete all but the last 100 of this round. */
+        for (int i = 0; i < 900; ++i)
+          su_assert_eq (hm_del (m, round * 1000 + i), 1);
+        su_assert_eq (hm_del (m, round * 1000), 0);
+      }
+    su_assert_eq (hm_size (m), 20 * 100);
+    hm_for_each (m, it)
+      su_assert_eq (it->key % 1000, it->value);
+    for (int round = 0; round < 20; ++round)
+      for (int i = 0; i < 1000; ++i)
+        su_assert_eq (hm_geti (m, round * 1000 + i) < 0, i < 900);
+    hm_free (m);
+  })
+})
+
+su_module (string_vector_tests, {
+  su_test ("vector_appendf", {
+    VECTOR(char) s = NULL;
+    vector_appendf (s, "%d-%s", 42, "abc");
+    su_assert_eq (vector_size (s), 6);
+    su_assert (!strcmp (s, "42-abc"));
+    /* Longer than the spare capacity. */
+    vector_appendf (s, "%0100d", 7);
+    su_assert_eq (vector_size (s), 106);
+    su_assert_eq (s[105], '7');
+    su_assert_eq (s[106], '\0');
+    vector_clear (s);
+    const size_t capacity = vector_capacity (s);
+    vector_appendf (s, "%s", "");
+    su_assert_eq (vector_size (s), 0);
+    su_assert_eq (vector_capacity (s), capacity);
+    vector_free (s);
+  })
+
+  su_test ("vector_append_str", {
+    VECTOR(char) s = NULL;
+    vector_append_str (s, "hello");
+    vector_append_mem (s, ", world!!", 7);
+    su_assert_eq (vector_size (s), 12);
+    su_assert (!strcmp (s, "hello, world"));
+    (void)vector_pop (s);
+    su_assert (!strcmp (vector_cstr (s), "hello, worl"));
+    vector_free (s);
+    VECTOR(char) empty = NULL;
+    su_assert (!strcmp (vector_cstr (empty), ""));
+    su_assert_eq (vector_size (empty), 0);
+    vector_free (empty);
+  })
+
+  su_test ("vector_append_number", {
+    VECTOR(char) s = NULL;
+    vector_append_int (s, 0);
+    vector_push (s, ' ');
+    vector_append_int (s, -7);
+    vector_push (s, ' ');
+    vector_append_int (s, 1234567);
+    vector_push (s, ' ');
+    vector_append_int (s, INT64_MIN);
+    vector_push (s, ' ');
+    vector_append_uint (s, UINT64_MAX);
+    su_assert (!strcmp (vector_cstr (s),
+                        "0 -7 1234567 -9223372036854775808 18446744073709551615"));
+    vector_clear (s);
+    vector_append_double (s, 0.1);
+    vector_push (s, ' ');
+    vector_append_double (s, -2.5e-300);
+    vector_push (s, ' ');
+    vector_append_double (s, 1.0 / 3);
+    vector_push (s, ' ');
+    vector_append_double (s, -3.0);
+    vector_push (s, ' ');
+    vector_append_double (s, 1e15);
+    su_assert (!strcmp (vector_cstr (s),
+                        "0.1 -2.5e-300 0.33333333333333331 -3 1e+15"));
+    vector_free (s);
+  })
+})
+
+#ifdef VECTOR__DECLTYPE
+su_module (vector_pipe_tests, {
+  su_test ("vector_pipe_collect", {
+    VECTOR(int) v = vector_create_from (G_int_buffer, 10);
+    VECTOR(int) out = NULL;
+    vector_pipe_collect (out, v, x, map (x * 3), filter (x % 2 == 0));
+    su_assert (check (out, 5, 0, 6, 12, 18, 24));
+    vector_pipe_collect (out, v, x, skip (2), filter (x != 5), take (4), map (-x));
+    su_assert (check (out, 9, 0, 6, 12, 18, 24, -2, -3, -4, -6));
+    vector_clear (out);
+    vector_pipe_collect (out, v, x);
+    su_assert (check (out, 10, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9));
+    vector_free (out);
+    VECTOR(int) none = NULL;
+    vector_pipe_collect (none, (int *)NULL, x, map (x + 1));
+    su_assert_eq (none, NULL);
+    /* Reserved for the smallest take limit, not the size of V. */
+    out = NULL;
+    vector_pipe_collect (out, v, x, take (8), filter (x & 1), take (3));
+    su_assert (check (out, 3, 1, 3, 5));
+    su_assert_eq (vector_capacity (out), 3);
+    vector_free (out);
+    vector_pipe_collect (none, v, x, take (0));
+    su_assert_eq (none, NULL);
+    vector_free (v);
+  })
+
+  su_test ("vector_pipe_map_type", {
+    VECTOR(int) v = vector_init (1, 2, 4);
+    VECTOR(double) out = NULL;
+    vector_pipe_collect (out, v, x, map (x / 2.0), filter (x < 2.0));
+    su_assert_eq (vector_size (out), 2);
+    su_assert_eq (out[0], 0.5);
+    su_assert_eq (out[1], 1.0);
+    vector_free (out);
+    vector_free (v);
+  })
+
+  su_test ("vector_pipe_reduce", {
+    VECTOR(int) v = vector_create_from (G_int_buffer, 10);
+    long sum = 0;
+    size_t n = 0;
+    vector_pipe_reduce (sum, sum + x, v, x, filter (x & 1), map ((long)x * x));
+    su_assert_eq (sum, 1 + 9 + 25 + 49 + 81);
+    vector_pipe_count (n, v, x, filter (x > 2), take (3));
+    su_assert_eq (n, 3);
+    n = 0;
+    vector_pipe_count (n, v, x, take (0));
+    su_assert_eq (n, 0);
+    vector_free (v);
+  })
+})
+#endif
+
 int main() {
   su_run_module(vector_tests);
+#ifndef VECTOR_AUTO_SHRINK
   su_run_module(static_vector_tests);
+#endif
+  su_run_module(packed_vector_tests);
+  su_run_module(bit_vector_tests);
+  su_run_module(jagged_vector_tests);
+  su_run_module(sorted_vector_tests);
+  su_run_module(hash_map_tests);
+  su_run_module(string_vector_tests);
+#ifdef VECTOR__DECLTYPE
+  su_run_module(vector_pipe_tests);
+#endif
 }
 
@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <memory_resource>
+#include <numeric>
+#include "smallunit.h"
+/* test_cpp_link links against the implementation compiled as C instead. */
+#ifndef TEST_C_IMPLEMENTATION
+#define VECTOR_IMPLEMENTATION
+#endif
+#include "vector.hpp"
+
+using c_vector::vector;
+
+static_assert (vector<int>::element_size == sizeof (int), "");
+static_assert (sizeof (vector<int>) == 2 * sizeof (void *), "");
+
+/* Memory resource that counts the bytes it hands out. */
+class counting_resource : public std::pmr::memory_resource
+{
+public:
+  size_t allocated = 0, live = 0;
+
+private:
+  void *
+  do_allocate (size_t bytes, size_t alignment) override
+  {
+    allocated += bytes;
+    live += bytes;
+    return std::pmr::new_delete_resource ()->allocate (bytes, alignment);
+  }
+
+  void
+  do_deallocate (void *p, size_t bytes, size_t alignment) override
+  {
+    live -= bytes;
+    std::pmr::new_delete_resource ()->deallocate (p, bytes, alignment);
+  }
+
+  bool
+  do_is_equal (const std::pmr::memory_resource &other) const noexcept override
+  {
+    return this == &other;
+  }
+};
+
+su_module (vector_hpp_tests, {
+  su_test ("push_back", {
+    vector<int> v;
+    su_assert (v.empty ());
+    su_assert_eq (v.get (), nullptr);
+    for (int i = 0; i < 100; ++i)
+      v.push_back (i);
+    su_assert_eq (v.size (), 100u);
+    su_assert_eq (v.capacity (), 128u);
+    su_assert_eq (v.back (), 99);
+    v.push_back (v[0]);
+    su_assert_eq (v.back (), 0);
+    v.pop_back ();
+    su_assert_eq (std::accumulate (v.begin (), v.end (), 0), 4950);
+    su_assert_eq (vector_size (v.get ()), 100u);
+    su_assert_eq (v.emplace_back (7), 7);
+  })
+
+  su_test ("iterators", {
+    vector<int> v = { 5, 3, 9, 1, 7 };
+    std::sort (v.begin (), v.end ());
+    su_assert ((v == vector<int>{ 1, 3, 5, 7, 9 }));
+    su_assert_eq (*std::lower_bound (v.begin (), v.end (), 6), 7);
+    su_assert_eq (*v.rbegin (), 9);
+    v.insert (v.begin () + 1, 2);
+    v.erase (v.begin () + 3, v.begin () + 5);
+    su_assert ((v == vector<int>{ 1, 2, 3, 9 }));
+    const vector<int> c (v.rbegin (), v.rend ());
+    su_assert ((c == vector<int>{ 9, 3, 2, 1 }));
+    bool thrown = false;
+    try
+      {
+        (void)c.at (4);
+      }
+    catch (const std::out_of_range &)
+      {
+        thrown = true;
+      }
+    su_assert (thrown);
+  })
+
+  su_test ("move", {
+    vector<int> a (10, 3);
+    int *const data = a.data ();
+    vector<int> b (std::move (a));
+    su_assert_eq (b.data (), data);
+    su_assert_eq (a.get (), nullptr);
+    vector<int> c;
+    c = std::move (b);
+    su_assert_eq (c.data (), data);
+    su_assert_eq (c.size (), 10u);
+    vector<int> d = c;
+    su_assert (d.data () != c.data ());
+    su_assert (d == c);
+  })
+
+  su_test ("c_interop", {
+    VECTOR(int) cv = vector_init (1, 2, 3);
+    vector<int> v = vector<int>::adopt (cv);
+    v.push_back (4);
+    VECTOR(int) back = v.release ();
+    su_assert_eq (vector_size (back), 4u);
+    vector_push (back, 5);
+    su_assert_eq (back[4], 5);
+    vector_free (back);
+  })
+
+  su_test ("memory_resource", {
+    counting_resource resource;
+    {
+      vector<double> v (&resource);
+      for (int i = 0; i < 1000; ++i)
+        v.push_back (i * 0.5);
+      su_assert (resource.allocated > 1000 * sizeof (double));
+      su_assert_eq (resource.live, sizeof (struct vector__header)
+                                   + v.capacity () * sizeof (double));
+      v.shrink_to_fit ();
+      su_assert_eq (v.capacity (), 1000u);
+      su_assert_eq (v[999], 499.5);
+      vector<double> copy = v;
+      su_assert_eq (copy.resource (), &resource);
+      /* Released into storage C code can free. */
+      double *const c = copy.release ();
+      su_assert_eq (vector_size (c), 1000u);
+      su_assert_eq (c[999], 499.5);
+      vector_push (c, 1.0);
+      vector_free (c);
+      su_assert_eq (resource.live, sizeof (struct vector__header)
+                                   + v.capacity () * sizeof (double));
+    }
+    su_assert_eq (resource.live, 0u);
+    std::pmr::monotonic_buffer_resource arena;
+    vector<int> v (&arena);
+    v.resize (100, 1);
+    su_assert_eq (std::accumulate (v.begin (), v.end (), 0), 100);
+  })
+})
+
+int main() {
+  su_run_module(vector_hpp_tests);
+}
@@ -10,6 +10,9 @@
 #include <stdarg.h>
 #include <stdint.h>
 #include <limits.h>
+#if defined (__SSE2__)
+#include <emmintrin.h>
+#endif
 
 #ifndef VECTOR_MALLOC
 #define VECTOR_MALLOC(_size) malloc(_size)
@@ -23,9 +26,96 @@
 #define VECTOR_REALLOC(_ptr, _old_size, _new_size) realloc(_ptr, _new_size)
 #endif
 
+/* With VECTOR_CACHE defined, freed vectors are kept in a thread-local cache,
+   bucketed by size class, and reused by the vector creation functions instead
+   of calling VECTOR_MALLOC again. Each class holds at most
+   VECTOR_CACHE_MAX_BLOCKS blocks (see vector_cache_limit), blocks larger than
+   VECTOR_CACHE_MAX_BYTES are never cached. A reused block may hold more
+   elements than asked for, the capacity of the vector is then raised to what
+   it holds. Threads should call vector_cache_flush before exiting. */
+#ifdef VECTOR_CACHE
+# ifndef VECTOR_CACHE_MAX_BLOCKS
+#  define VECTOR_CACHE_MAX_BLOCKS 32
+# endif
+# ifndef VECTOR_CACHE_MAX_BYTES
+#  define VECTOR_CACHE_MAX_BYTES 65536
+# endif
+# define VECTOR__FREE_BLOCK(_ptr, _size) vector__cache_free(_ptr, _size)
+#else
+# define VECTOR__FREE_BLOCK(_ptr, _size) VECTOR_FREE(_ptr, _size)
+#endif
+
+/* Copies of at least this many bytes by vector_push_vector, vector_copy and
+   vector_clone use non-temporal stores that bypass the cache, so they don't
+   evict the working set. 0 picks half the size of the last level cache at
+   runtime. Can be changed with vector_set_streaming_threshold. */
+#ifndef VECTOR_STREAMING_THRESHOLD
+#define VECTOR_STREAMING_THRESHOLD 0
+#endif
+
+/* Copies below this many bytes never stream whatever the threshold is, this
+   check is inlined so small copies stay as fast as a plain memcpy. */
+#ifndef VECTOR_STREAMING_MIN
+#define VECTOR_STREAMING_MIN 65536
+#endif
+
+/* How many bytes ahead of the source streaming copies prefetch, 0 leaves it
+   to the hardware prefetcher which handles linear copies well on most CPUs. */
+#ifndef VECTOR_STREAMING_PREFETCH
+#define VECTOR_STREAMING_PREFETCH 0
+#endif
+
+#ifndef VECTOR__THREAD_LOCAL
+# if defined (__cplusplus) && __cplusplus >= 201103L
+#  define VECTOR__THREAD_LOCAL thread_local
+# elif defined (__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+#  define VECTOR__THREAD_LOCAL _Thread_local
+# elif defined (__GNUC__)
+#  define VECTOR__THREAD_LOCAL __thread
+# endif
+#endif /* VECTOR__THREAD_LOCAL */
+
+#if defined (VECTOR_CACHE) && !defined (VECTOR__THREAD_LOCAL)
+# error "VECTOR_CACHE needs thread-local storage, define VECTOR__THREAD_LOCAL"
+#endif
+
+/* With VECTOR_AUTO_SHRINK defined, vector_pop, vector_remove, vector_erase
+   and vector_clear halve the capacity (repeatedly, with a single realloc)
+   while the size is below 1/VECTOR_SHRINK_DIVISOR of it, but not below
+   VECTOR_SHRINK_MIN_CAPACITY elements. A shrunk vector has to double in size
+   before it grows again, so pushes and pops around one size don't make it
+   oscillate. vector_shrink_count tells how often the calling thread shrank a
+   vector. Static vectors can't be used with it. */
+#ifdef VECTOR_AUTO_SHRINK
+# ifndef VECTOR_SHRINK_DIVISOR
+#  define VECTOR_SHRINK_DIVISOR 4
+# endif
+# ifndef VECTOR_SHRINK_MIN_CAPACITY
+#  define VECTOR_SHRINK_MIN_CAPACITY 16
+# endif
+# if VECTOR_SHRINK_DIVISOR < 2
+#  error "VECTOR_SHRINK_DIVISOR must be at least 2"
+# endif
+# ifndef VECTOR__THREAD_LOCAL
+#  error "VECTOR_AUTO_SHRINK needs thread-local storage, define VECTOR__THREAD_LOCAL"
+# endif
+#endif
+
+/* With VECTOR_COMPACT_HEADER defined the size and capacity are stored as 32-bit
+   integers, halving the header to 8 bytes at the cost of limiting vectors to
+   VECTOR_MAX_SIZE elements. The vector data is then only 8-byte aligned. It
+   has to be defined the same way in every file using vectors. */
+#ifdef VECTOR_COMPACT_HEADER
+# define VECTOR__SIZE_T uint32_t
+# define VECTOR_MAX_SIZE ((size_t)UINT32_MAX)
+#else
+# define VECTOR__SIZE_T size_t
+# define VECTOR_MAX_SIZE ((size_t)SIZE_MAX)
+#endif
+
 struct vector__header {
-  size_t size;
-  size_t capacity;
+  VECTOR__SIZE_T size;
+  VECTOR__SIZE_T capacity;
   char data[];
 };
 
@@ -66,21 +156,37 @@ struct vector__header {
 
 /* Grow the vector so it can fit at least N more items. */
 #define vector__grow(v, n) (*((void **)&(v)) = vector__grow_impl((v), (n), sizeof(*(v))))
-/* Check if the vector needs to grow to accommodate N more items. */
-#define vector__needgrow(v, n) ((v) == NULL || vector__size(v) + (n) > vector__capacity(v))
+/* Check if the vector needs to grow to accommodate N more items. Computed in
+   size_t so it doesn't wrap with VECTOR_COMPACT_HEADER. */
+#define vector__needgrow(v, n)\
+  ((v) == NULL || (size_t)vector__size(v) + (size_t)(n) > (size_t)vector__capacity(v))
 /* Ensure that the vector can fit N more items, grow it if necessary. */
 #define vector__maybegrow(v, n) (vector__needgrow((v), (n)) ? vector__grow((v), (n)) : 0)
 
+#ifdef VECTOR_AUTO_SHRINK
+/* Check if the vector should shrink when its size becomes N. */
+#define vector__needshrink(v, n)                                       \
+  ((v) != NULL && vector__capacity (v) / 2 >= VECTOR_SHRINK_MIN_CAPACITY \
+   && (size_t)(n) < vector__capacity (v) / VECTOR_SHRINK_DIVISOR)
+/* Shrink the vector for a size of N if the policy says so. */
+#define vector__maybeshrink(v, n)                                            \
+  (vector__needshrink ((v), (n))                                             \
+   ? (void)(*((void **)&(v)) = vector__shrink_impl ((v), (n), sizeof (*(v)))) \
+   : (void)0)
+#else
+#define vector__maybeshrink(v, n) ((void)0)
+#endif
+
 /* Same as `T *`, represents a owned vector. */
 #define VECTOR(T) T *
 
 /* Gets the number of elements in the vector. */
 #define vector_size(v)\
-  ((v) == NULL ? 0 : vector__size(v))
+  ((v) == NULL ? 0 : (size_t)vector__size(v))
 
 /* Gets the number of elements that fit in the vector. */
 #define vector_capacity(v)\
-  ((v) == NULL ? 0 : vector__capacity(v))
+  ((v) == NULL ? 0 : (size_t)vector__capacity(v))
 
 /* Checks if the vector is empty. */
 #define vector_empty(v)\
@@ -143,14 +249,15 @@ struct vector__header {
 #define vector_push_vector(v, other)                     \
   ((other)                                               \
    ? (vector__maybegrow ((v), vector__size (other)),     \
-      memcpy ((v) + vector__size (v), (other),           \
+      vector__copy_bytes ((v) + vector__size (v), (other), \
               vector__size (other) * sizeof (*(other))), \
       vector__size (v) += vector__size (other))          \
    : 0)
 
 /* Gets and removes the last element of the vector. */
-#define vector_pop(v)\
-  ((v)[--vector__size(v)])
+#define vector_pop(v)                             \
+  (vector__maybeshrink ((v), vector__size (v) - 1), \
+   (v)[--vector__size(v)])
 
 /* Inserts a new element into the vector at position I. */
 #define vector_insert(v, i, e)                                \
@@ -177,18 +284,22 @@ struct vector__header {
   (((v) == NULL || (size_t)(i) >= vector_size(v))                  \
    ? 0                                                             \
    : (vector__shift((char *)(void *)(v), (i+1), -1, sizeof(*(v))), \
-      --vector__size(v)))
+      --vector__size(v),                                           \
+      vector__maybeshrink ((v), vector__size (v)),                 \
+      vector__size (v)))
 
 /* Removes N elements from the vector, starting at position I. */
 #define vector_erase(v, i, n)                                               \
   (((v) == NULL || (size_t)(i) > (vector__size (v) - (n)))                  \
    ? 0                                                                      \
    : (vector__shift ((char *)(void *)(v), (i)+(n), 0LL-(n), sizeof (*(v))), \
-      vector__size (v) -= (n)))
+      vector__size (v) -= (n),                                              \
+      vector__maybeshrink ((v), vector__size (v)),                          \
+      vector__size (v)))
 
 /* Clears the contents of the vector. */
 #define vector_clear(v)\
-  ((v) == NULL ? 0 : (vector__size (v) = 0))
+  ((v) == NULL ? 0 : (vector__size (v) = 0, vector__maybeshrink ((v), 0), 0))
 
 /* Resizes the vector. */
 #define vector_resize(v, n)\
@@ -219,10 +330,49 @@ struct vector__header {
           (p),                                                \
           (n) * sizeof(*(p)))
 
+/* Allocates storage for N elements of type T that a producer can fill like a
+   plain buffer and later turn into a vector with vector_adopt. */
+#define vector_alloc_buffer(T, n)\
+  vector_create(T, n)
+
+/* Turns a buffer from vector_alloc_buffer into a vector whose first N
+   elements are used, without copying. N is clamped to the capacity. */
+#define vector_adopt(p, n)                                  \
+  (vector__size (p) = ((size_t)(n) < vector__capacity (p)   \
+                       ? (n) : vector__capacity (p)),       \
+   (p))
+
+/* Turns a plain VECTOR_MALLOC'd buffer of N elements into a vector. This
+   reallocates the buffer to make room for the header and moves the elements,
+   so unlike vector_adopt it is O(N). The result has to be assigned. */
+#define vector_adopt_malloc(p, n)\
+  vector__adopt_malloc ((void *)(p), (n), sizeof (*(p)))
+
+/* Gives up ownership of the vectors storage and returns it as a plain pointer
+   that can be passed to VECTOR_FREE. The elements are moved to the start of
+   the allocation, nothing is copied to new memory. V becomes NULL and if LEN
+   is not NULL the number of elements is stored in it. */
+#define vector_release(v, len)\
+  vector__release ((void **)&(v), sizeof (*(v)), (len))
+
+/* Swaps the vectors A and B. */
+#define vector_swap(a, b)              \
+  ((void)sizeof ((a) == (b)),          \
+   vector__swap ((void **)&(a), (void **)&(b)))
+
+/* Frees DST and transfers ownership of SRC to it, SRC becomes NULL. */
+#define vector_move(dst, src)                           \
+  ((void)sizeof ((dst) == (src)),                       \
+   ((dst) != (src)                                      \
+    ? (vector_free (dst),                               \
+       vector__swap ((void **)&(dst), (void **)&(src)), \
+       (void)(*((void **)&(src)) = NULL))               \
+    : (void)0))
+
 /* Frees the vector. */
 #define vector_free(v)                                                          \
     ((v)                                                                        \
-     ? (VECTOR_FREE(                                                            \
+     ? (VECTOR__FREE_BLOCK(                                                     \
           vector__get(v),                                                       \
           vector__get(v)->capacity * sizeof(*v) + sizeof(struct vector__header) \
         ),                                                                      \
@@ -248,6 +398,17 @@ struct vector__header {
              : ((void)vector_clear (dst), dst))                    \
           : vector_clone (src)))
 
+/* Like vector_copy but always bypasses the cache for the copied data, see
+   VECTOR_STREAMING_THRESHOLD. */
+#define vector_copy_streaming(dst, src)                                   \
+  (dst = (src                                                             \
+          ? vector__copy_impl (dst                                        \
+                               ? vector__get (dst)                        \
+                               : vector__get (vector__create (            \
+                                   vector__size (src), sizeof (*dst))),   \
+                               vector__get (src), sizeof (*dst), 1)       \
+          : ((void)vector_clear (dst), dst)))
+
 #ifdef VECTOR__DECLTYPE
 /* Iterate over the vector, IT recieves a pointer to each element */
 #define vector_for_each(v, it)                                             \
@@ -284,6 +445,12 @@ struct vector__header {
                      the size, second to do the selection. */              \
                   __VA_ARGS__, INT_MIN, __VA_ARGS__, INT_MIN)
 
+/* C linkage so C++ files can use the implementation compiled as C. */
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void vector__check_size (size_t elems);
 void* vector__resize_impl(void *data, size_t elems, size_t elem_size);
 void* vector__grow_impl(void *data, size_t size, size_t elem_size);
 void vector__shift(char *data, size_t index, long diff, size_t elem_size);
@@ -291,11 +458,55 @@ void* vector__create(size_t capacity, size_t elem_size);
 void* vector__create_with_size (size_t capacity, size_t elem_size, size_t size);
 void* vector__copy (struct vector__header *dest, struct vector__header *source,
                     size_t elem_size);
+void* vector__copy_impl (struct vector__header *dest,
+                         struct vector__header *source, size_t elem_size,
+                         int streaming);
+/* Only called for large copies, which take long enough that the call doesn't
+   matter. Cold keeps it from being inlined into every copy. */
+#ifdef __GNUC__
+__attribute__ ((cold))
+#endif
+void* vector__memcpy (void *dest, const void *source, size_t size);
+void* vector__memcpy_streaming (void *dest, const void *source, size_t size);
+size_t vector__streaming_threshold (void);
+
+/* memcpy for vector_push_vector and vector_copy. Copies too small to ever
+   stream stay a plain memcpy without any call or threshold lookup. */
+#define vector__copy_bytes(dest, source, size)                          \
+  ((size_t)(size) < VECTOR_STREAMING_MIN                                \
+   ? memcpy ((dest), (source), (size))                                  \
+   : vector__memcpy ((dest), (source), (size)))
+/* Sets the size in bytes from which copies bypass the cache, 0 to detect it
+   again. */
+void vector_set_streaming_threshold (size_t bytes);
 int vector__compare (const void *a, const void *b,
                      size_t elem_size_a, size_t elem_size_b);
 void* vector__slice (const void *data, size_t elem_size, size_t size,
                      ptrdiff_t begin, ptrdiff_t end);
 void* vector__select (const void *data, size_t elem_size, size_t size, ...);
+void* vector__adopt_malloc (void *p, size_t size, size_t elem_size);
+void* vector__release (void **data, size_t elem_size, size_t *len);
+void vector__swap (void **a, void **b);
+void* vector__alloc (size_t *capacity, size_t elem_size);
+
+#ifdef VECTOR_AUTO_SHRINK
+/* Gets the number of times vectors were shrunk by the calling thread. */
+size_t vector_shrink_count (void);
+void* vector__shrink_impl (void *data, size_t size, size_t elem_size);
+#endif
+
+#ifdef VECTOR_CACHE
+/* Frees all blocks cached by the calling thread. */
+void vector_cache_flush (void);
+/* Sets the maximum number of cached blocks per size class for the calling
+   thread, excess blocks are freed. */
+void vector_cache_limit (size_t max_blocks);
+void vector__cache_free (void *block, size_t size);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
 
 #endif /* !VECTOR_H */
 
@@ -305,8 +516,37 @@ void* vector__select (const void *data, size_t elem_size, size_t size, ...);
 #ifndef VECTOR__IMPLEMENTED
 #define VECTOR__IMPLEMENTED
 
-inline void *
+/* sysconf, to find the size of the last level cache. */
+#if defined (__unix__) || defined (__APPLE__)
+#include <unistd.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The prototypes aren't inline, so in C these inline definitions are the
+   external ones. C++ only emits inline functions where they're used, there
+   they're plain functions so other files can link against them. */
+#ifdef __cplusplus
+# define VECTOR__INLINE
+#else
+# define VECTOR__INLINE inline
+#endif
+
+VECTOR__INLINE void
+vector__check_size (size_t elems)
+{
+  if (elems > VECTOR_MAX_SIZE)
+    {
+      fputs ("vector: size exceeds VECTOR_MAX_SIZE\n", stderr);
+      exit (1);
+    }
+}
+
+VECTOR__INLINE void *
 vector__resize_impl(void *data, size_t elems, size_t elem_size) {
+  vector__check_size (elems);
   struct vector__header *v = (struct vector__header *)VECTOR_REALLOC (
     data ? vector__get (data) : NULL,
     data ? vector__capacity (data) * elem_size + sizeof (struct vector__header) : 0,
@@ -327,53 +567,159 @@ vector__resize_impl(void *data, size_t elems, size_t elem_size) {
     }
 }
 
-inline void *
+VECTOR__INLINE void *
 vector__grow_impl(void *data, size_t size, size_t elem_size) {
   size_t min_needed = vector_size (data) + size;
   size_t default_growth = data ? (vector__capacity (data) << 1) : 16;
   size_t new_capacity = (default_growth > min_needed
                          ? default_growth
                          : min_needed);
+  /* Don't let doubling alone push the capacity over the limit. */
+  if (new_capacity > VECTOR_MAX_SIZE && min_needed <= VECTOR_MAX_SIZE)
+    new_capacity = VECTOR_MAX_SIZE;
   return vector__resize_impl (data, new_capacity, elem_size);
 }
 
-inline void
+VECTOR__INLINE void
 vector__shift(char *data, size_t index, long diff, size_t elem_size) {
   char *at = data + index * elem_size;
   size_t count = vector__size (data) - index;
   memmove (at + diff * elem_size, at, count * elem_size);
 }
 
-inline void *
+VECTOR__INLINE void *
 vector__create(size_t capacity, size_t elem_size) {
-  struct vector__header *v = (struct vector__header *)VECTOR_MALLOC(
-    capacity * elem_size + sizeof (struct vector__header));
+  vector__check_size (capacity);
+  struct vector__header *v = (struct vector__header *)vector__alloc (
+    &capacity, elem_size);
   v->size = 0;
   v->capacity = capacity;
   return (void *)v->data;
 }
 
-inline void *
+VECTOR__INLINE void *
 vector__create_with_size (size_t capacity, size_t elem_size, size_t size) {
-  struct vector__header *v = (struct vector__header *)VECTOR_MALLOC(
-    capacity * elem_size + sizeof (struct vector__header));
+  vector__check_size (capacity);
+  struct vector__header *v = (struct vector__header *)vector__alloc (
+    &capacity, elem_size);
   v->size = size;
   v->capacity = capacity;
   return (void *)v->data;
 }
 
-inline void *
+VECTOR__INLINE void *
 vector__copy (struct vector__header *dest, struct vector__header *source,
               size_t elem_size)
+{
+  return vector__copy_impl (dest, source, elem_size, 0);
+}
+
+VECTOR__INLINE void *
+vector__copy_impl (struct vector__header *dest, struct vector__header *source,
+                   size_t elem_size, int streaming)
 {
   if (source->size > dest->capacity)
     dest = vector__get (vector__resize_impl (dest->data, source->size,
                                              elem_size));
   dest->size = source->size;
-  return memcpy (dest->data, source->data, source->size * elem_size);
+  if (streaming)
+    return vector__memcpy_streaming (dest->data, source->data,
+                                     source->size * elem_size);
+  return vector__copy_bytes (dest->data, source->data,
+                             source->size * elem_size);
+}
+
+/* 0 until it's detected. Accessed atomically, threads may detect it at the
+   same time. */
+static size_t vector__streaming_bytes = VECTOR_STREAMING_THRESHOLD;
+
+VECTOR__INLINE size_t
+vector__streaming_threshold (void)
+{
+#ifdef __GNUC__
+  size_t bytes = __atomic_load_n (&vector__streaming_bytes, __ATOMIC_RELAXED);
+#else
+  size_t bytes = vector__streaming_bytes;
+#endif
+  if (bytes == 0)
+    {
+      size_t llc = 0, expected = 0;
+#ifdef _SC_LEVEL3_CACHE_SIZE
+      const long l3 = sysconf (_SC_LEVEL3_CACHE_SIZE);
+      if (l3 > 0)
+        llc = (size_t)l3;
+#endif
+      bytes = llc ? llc / 2 : (size_t)4 << 20;
+      /* Keep a value stored by another thread in the meantime. */
+#ifdef __GNUC__
+      if (!__atomic_compare_exchange_n (&vector__streaming_bytes, &expected,
+                                        bytes, 0, __ATOMIC_RELAXED,
+                                        __ATOMIC_RELAXED))
+        bytes = expected;
+#else
+      (void)expected;
+      vector__streaming_bytes = bytes;
+#endif
+    }
+  return bytes;
+}
+
+VECTOR__INLINE void
+vector_set_streaming_threshold (size_t bytes)
+{
+#ifdef __GNUC__
+  __atomic_store_n (&vector__streaming_bytes, bytes, __ATOMIC_RELAXED);
+#else
+  vector__streaming_bytes = bytes;
+#endif
+}
+
+VECTOR__INLINE void *
+vector__memcpy (void *dest, const void *source, size_t size)
+{
+  if (size >= vector__streaming_threshold ())
+    return vector__memcpy_streaming (dest, source, size);
+  return memcpy (dest, source, size);
 }
 
-inline int
+VECTOR__INLINE void *
+vector__memcpy_streaming (void *dest, const void *source, size_t size)
+{
+#if defined (__SSE2__)
+  char *d = (char *)dest;
+  const char *s = (const char *)source;
+  const size_t head = (16 - ((uintptr_t)d & 15)) & 15;
+  if (size < head + 64)
+    return memcpy (dest, source, size);
+  memcpy (d, s, head);
+  d += head;
+  s += head;
+  size -= head;
+  for (; size >= 64; size -= 64, d += 64, s += 64)
+    {
+#if VECTOR_STREAMING_PREFETCH > 0
+      /* Prefetching past the end of the source is harmless. */
+      _mm_prefetch (s + VECTOR_STREAMING_PREFETCH, _MM_HINT_NTA);
+#endif
+      const __m128i a = _mm_loadu_si128 ((const __m128i *)(const void *)s);
+      const __m128i b = _mm_loadu_si128 ((const __m128i *)(const void *)(s + 16));
+      const __m128i c = _mm_loadu_si128 ((const __m128i *)(const void *)(s + 32));
+      const __m128i e = _mm_loadu_si128 ((const __m128i *)(const void *)(s + 48));
+      _mm_stream_si128 ((__m128i *)(void *)d, a);
+      _mm_stream_si128 ((__m128i *)(void *)(d + 16), b);
+      _mm_stream_si128 ((__m128i *)(void *)(d + 32), c);
+      _mm_stream_si128 ((__m128i *)(void *)(d + 48), e);
+    }
+  /* Make the non-temporal stores visible before anything else. */
+  _mm_sfence ();
+  memcpy (d, s, size);
+  return dest;
+#else
+  return memcpy (dest, source, size);
+#endif
+}
+
+VECTOR__INLINE int
 vector__compare (const void *a, const void *b,
                  size_t elem_size_a, size_t elem_size_b)
 {
@@ -385,7 +731,7 @@ vector__compare (const void *a, const void *b,
   return cmp;
 }
 
-inline void *
+VECTOR__INLINE void *
 vector__slice (const void *data, size_t elem_size, size_t size,
                ptrdiff_t begin, ptrdiff_t end)
 {
@@ -417,7 +763,7 @@ vector__slice (const void *data, size_t elem_size, size_t size,
                  len * elem_size);
 }
 
-inline void *
+VECTOR__INLINE void *
 vector__select (const void *data, size_t elem_size, size_t size, ...)
 {
   int count = 0, idx;
@@ -441,5 +787,208 @@ vector__select (const void *data, size_t elem_size, size_t size, ...)
   return result;
 }
 
+VECTOR__INLINE void *
+vector__adopt_malloc (void *p, size_t size, size_t elem_size)
+{
+  struct vector__header *v;
+  if (!p)
+    return NULL;
+  vector__check_size (size);
+  v = (struct vector__header *)VECTOR_REALLOC (
+    p, size * elem_size, size * elem_size + sizeof (struct vector__header));
+  if (!v)
+    {
+      fputs ("vector__adopt_malloc: allocation failed\n", stderr);
+      exit (1);
+    }
+  memmove (v->data, v, size * elem_size);
+  v->size = size;
+  v->capacity = size;
+  return v->data;
+}
+
+VECTOR__INLINE void *
+vector__release (void **data, size_t elem_size, size_t *len)
+{
+  struct vector__header *v;
+  size_t size;
+  if (!*data)
+    {
+      if (len)
+        *len = 0;
+      return NULL;
+    }
+  v = vector__get (*data);
+  size = v->size;
+  memmove (v, v->data, size * elem_size);
+  *data = NULL;
+  if (len)
+    *len = size;
+  return v;
+}
+
+VECTOR__INLINE void
+vector__swap (void **a, void **b)
+{
+  void *t = *a;
+  *a = *b;
+  *b = t;
+}
+
+#ifdef VECTOR_AUTO_SHRINK
+static VECTOR__THREAD_LOCAL size_t vector__shrinks;
+
+VECTOR__INLINE void *
+vector__shrink_impl (void *data, size_t size, size_t elem_size)
+{
+  size_t capacity = vector__capacity (data);
+  while (size < capacity / VECTOR_SHRINK_DIVISOR
+         && capacity / 2 >= VECTOR_SHRINK_MIN_CAPACITY)
+    capacity /= 2;
+  if (capacity == vector__capacity (data))
+    return data;
+  ++vector__shrinks;
+  return vector__resize_impl (data, capacity, elem_size);
+}
+
+VECTOR__INLINE size_t
+vector_shrink_count (void)
+{
+  return vector__shrinks;
+}
+#endif
+
+#ifdef VECTOR_CACHE
+/* Cached blocks are linked through their first bytes and remember how many
+   bytes they are known to hold. */
+struct vector__cache_block {
+  struct vector__cache_block *next;
+  size_t size;
+};
+
+#define VECTOR__CACHE_CLASSES 64
+
+static VECTOR__THREAD_LOCAL struct {
+  struct vector__cache_block *head[VECTOR__CACHE_CLASSES];
+  size_t count[VECTOR__CACHE_CLASSES];
+  size_t limit;
+  int limit_set;
+} vector__cache;
+
+/* Size class of a block of SIZE bytes: the smallest N with `SIZE <= 2^N`. */
+static unsigned
+vector__cache_class (size_t size)
+{
+#ifdef __GNUC__
+  return size <= 1 ? 0 : 64 - __builtin_clzll ((unsigned long long)size - 1);
+#else
+  unsigned c = 0;
+  while (((size_t)1 << c) < size)
+    ++c;
+  return c;
+#endif
+}
+
+static void
+vector__cache_trim (unsigned c, size_t limit)
+{
+  while (vector__cache.count[c] > limit)
+    {
+      struct vector__cache_block *b = vector__cache.head[c];
+      vector__cache.head[c] = b->next;
+      --vector__cache.count[c];
+      VECTOR_FREE (b, b->size);
+    }
+}
+
+VECTOR__INLINE void
+vector__cache_free (void *block, size_t size)
+{
+  const size_t limit = (vector__cache.limit_set
+                        ? vector__cache.limit
+                        : VECTOR_CACHE_MAX_BLOCKS);
+  struct vector__cache_block *b = (struct vector__cache_block *)block;
+  unsigned c;
+  if (size < sizeof (struct vector__cache_block)
+      || size > VECTOR_CACHE_MAX_BYTES)
+    {
+      VECTOR_FREE (block, size);
+      return;
+    }
+  c = vector__cache_class (size);
+  if (vector__cache.count[c] >= limit)
+    {
+      VECTOR_FREE (block, size);
+      return;
+    }
+  b->size = size;
+  b->next = vector__cache.head[c];
+  vector__cache.head[c] = b;
+  ++vector__cache.count[c];
+}
+
+VECTOR__INLINE void
+vector_cache_flush (void)
+{
+  unsigned c;
+  for (c = 0; c < VECTOR__CACHE_CLASSES; ++c)
+    vector__cache_trim (c, 0);
+}
+
+VECTOR__INLINE void
+vector_cache_limit (size_t max_blocks)
+{
+  unsigned c;
+  vector__cache.limit = max_blocks;
+  vector__cache.limit_set = 1;
+  for (c = 0; c < VECTOR__CACHE_CLASSES; ++c)
+    vector__cache_trim (c, max_blocks);
+}
+#endif /* VECTOR_CACHE */
+
+/* Allocates a block for *CAPACITY elements of ELEM_SIZE bytes. A block from
+   the cache may be larger, then *CAPACITY is raised to what it holds. Only
+   blocks that hold a whole number of elements are taken, so the size computed
+   from the capacity is always the size the block was allocated with. */
+VECTOR__INLINE void *
+vector__alloc (size_t *capacity, size_t elem_size)
+{
+  const size_t size = *capacity * elem_size + sizeof (struct vector__header);
+#ifdef VECTOR_CACHE
+  if (size <= VECTOR_CACHE_MAX_BYTES && elem_size)
+    {
+      const unsigned c = vector__cache_class (size);
+      unsigned n;
+      /* Blocks in the same class may be a bit too small and blocks of the
+         next class may not fit whole elements, only look at the first few
+         of each. */
+      for (n = c; n <= c + 1 && n < VECTOR__CACHE_CLASSES; ++n)
+        {
+          struct vector__cache_block **link = &vector__cache.head[n];
+          int tries;
+          for (tries = 0; *link && tries < 4; ++tries, link = &(*link)->next)
+            {
+              struct vector__cache_block *b = *link;
+              const size_t data_size = b->size - sizeof (struct vector__header);
+              if (b->size >= size && data_size % elem_size == 0)
+                {
+                  *link = b->next;
+                  --vector__cache.count[n];
+                  *capacity = data_size / elem_size;
+                  return b;
+                }
+            }
+        }
+    }
+#else
+  (void)elem_size;
+#endif
+  return VECTOR_MALLOC (size);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* VECTOR__IMPLEMENTED */
 #endif /* VECTOR_IMPLEMENTATION */
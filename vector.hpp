@@ -0,0 +1,439 @@
+#ifndef VECTOR_HPP
+#define VECTOR_HPP
+#include "vector.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <memory_resource>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace c_vector
+{
+
+/* C++ wrapper around a VECTOR(T). It holds the same pointer to the data after
+   a `struct vector__header` as the C API, so `get` can be passed to C code
+   and `adopt`/`release` move vectors between C and C++ without copying.
+
+   Storage comes from a std::pmr::memory_resource if one is given, otherwise
+   from VECTOR_REALLOC/VECTOR_FREE like the C functions (and only then may C
+   code grow or free the vector). Elements are moved with realloc/memcpy, so
+   T has to be trivially copyable. */
+template <class T>
+class vector
+{
+  static_assert (std::is_trivially_copyable<T>::value,
+                 "vector elements are moved with memcpy and realloc");
+  static_assert (alignof (T) <= sizeof (struct vector__header),
+                 "the vector header only keeps the data aligned to its size");
+
+public:
+  using value_type = T;
+  using size_type = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference = T &;
+  using const_reference = const T &;
+  using pointer = T *;
+  using const_pointer = const T *;
+  using iterator = T *;
+  using const_iterator = const T *;
+  using reverse_iterator = std::reverse_iterator<iterator>;
+  using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+  /* Size of an element in bytes, what the C macros compute with sizeof. */
+  static constexpr size_type element_size = sizeof (T);
+
+  vector () noexcept = default;
+
+  explicit vector (std::pmr::memory_resource *resource) noexcept
+    : resource_ (resource)
+  {
+  }
+
+  explicit vector (size_type n, const T &value = T (),
+                   std::pmr::memory_resource *resource = nullptr)
+    : resource_ (resource)
+  {
+    resize (n, value);
+  }
+
+  vector (std::initializer_list<T> init,
+          std::pmr::memory_resource *resource = nullptr)
+    : resource_ (resource)
+  {
+    assign (init.begin (), init.end ());
+  }
+
+  template <class It, class = typename std::iterator_traits<It>::iterator_category>
+  vector (It first, It last, std::pmr::memory_resource *resource = nullptr)
+    : resource_ (resource)
+  {
+    assign (first, last);
+  }
+
+  /* Copies use the memory resource of OTHER. */
+  vector (const vector &other)
+    : resource_ (other.resource_)
+  {
+    assign (other.begin (), other.end ());
+  }
+
+  /* Takes the storage of OTHER, which is left empty. */
+  vector (vector &&other) noexcept
+    : data_ (other.data_), resource_ (other.resource_)
+  {
+    other.data_ = nullptr;
+  }
+
+  ~vector ()
+  {
+    deallocate (data_);
+  }
+
+  vector &
+  operator= (const vector &other)
+  {
+    if (this != &other)
+      assign (other.begin (), other.end ());
+    return *this;
+  }
+
+  vector &
+  operator= (vector &&other) noexcept
+  {
+    if (this != &other)
+      {
+        deallocate (data_);
+        data_ = other.data_;
+        resource_ = other.resource_;
+        other.data_ = nullptr;
+      }
+    return *this;
+  }
+
+  vector &
+  operator= (std::initializer_list<T> init)
+  {
+    assign (init.begin (), init.end ());
+    return *this;
+  }
+
+  /* Takes ownership of the C vector V. */
+  static vector
+  adopt (T *v) noexcept
+  {
+    vector result;
+    result.data_ = v;
+    return result;
+  }
+
+  /* Gives up ownership of the C vector, it has to be freed with vector_free.
+     With a memory resource the elements are copied into a new C vector
+     first, C code can't free memory of the resource. */
+  T *
+  release () noexcept
+  {
+    T *v = data_;
+    if (v && resource_)
+      {
+        v = static_cast<T *> (vector__create_with_size (size (), sizeof (T),
+                                                        size ()));
+        std::memcpy (v, data_, size () * sizeof (T));
+        deallocate (data_);
+      }
+    data_ = nullptr;
+    return v;
+  }
+
+  /* Gets the C vector, NULL if nothing was allocated yet. */
+  T *get () const noexcept { return data_; }
+
+  std::pmr::memory_resource *resource () const noexcept { return resource_; }
+
+  template <class It>
+  void
+  assign (It first, It last)
+  {
+    clear ();
+    if constexpr (std::is_base_of<std::forward_iterator_tag,
+                                  typename std::iterator_traits<It>::iterator_category>::value)
+      {
+        const size_type n = std::distance (first, last);
+        reserve (n);
+        std::copy (first, last, data_);
+        if (n)
+          vector__size (data_) = n;
+      }
+    else
+      for (; first != last; ++first)
+        push_back (*first);
+  }
+
+  iterator begin () noexcept { return data_; }
+  const_iterator begin () const noexcept { return data_; }
+  const_iterator cbegin () const noexcept { return data_; }
+  iterator end () noexcept { return data_ + size (); }
+  const_iterator end () const noexcept { return data_ + size (); }
+  const_iterator cend () const noexcept { return data_ + size (); }
+  reverse_iterator rbegin () noexcept { return reverse_iterator (end ()); }
+  const_reverse_iterator rbegin () const noexcept { return const_reverse_iterator (end ()); }
+  reverse_iterator rend () noexcept { return reverse_iterator (begin ()); }
+  const_reverse_iterator rend () const noexcept { return const_reverse_iterator (begin ()); }
+
+  size_type size () const noexcept { return vector_size (data_); }
+  size_type capacity () const noexcept { return vector_capacity (data_); }
+  bool empty () const noexcept { return size () == 0; }
+  size_type max_size () const noexcept { return VECTOR_MAX_SIZE; }
+
+  T *data () noexcept { return data_; }
+  const T *data () const noexcept { return data_; }
+  T &operator[] (size_type i) noexcept { return data_[i]; }
+  const T &operator[] (size_type i) const noexcept { return data_[i]; }
+  T &front () noexcept { return data_[0]; }
+  const T &front () const noexcept { return data_[0]; }
+  T &back () noexcept { return data_[size () - 1]; }
+  const T &back () const noexcept { return data_[size () - 1]; }
+
+  T &
+  at (size_type i)
+  {
+    if (i >= size ())
+      throw std::out_of_range ("c_vector::vector::at");
+    return data_[i];
+  }
+
+  const T &
+  at (size_type i) const
+  {
+    if (i >= size ())
+      throw std::out_of_range ("c_vector::vector::at");
+    return data_[i];
+  }
+
+  void
+  reserve (size_type n)
+  {
+    if (n > capacity ())
+      reallocate (n);
+  }
+
+  void
+  shrink_to_fit ()
+  {
+    if (data_ && size () < capacity ())
+      reallocate (size ());
+  }
+
+  void
+  push_back (const T &value)
+  {
+    if (size () == capacity ())
+      {
+        /* VALUE may be an element of this vector. */
+        const T copy = value;
+        grow (1);
+        data_[vector__size (data_)++] = copy;
+      }
+    else
+      data_[vector__size (data_)++] = value;
+  }
+
+  template <class... Args>
+  T &
+  emplace_back (Args &&...args)
+  {
+    if (size () == capacity ())
+      {
+        /* ARGS may refer to elements of this vector. */
+        const T value (std::forward<Args> (args)...);
+        grow (1);
+        return data_[vector__size (data_)++] = value;
+      }
+    T *const p = ::new (data_ + vector__size (data_)) T (std::forward<Args> (args)...);
+    ++vector__size (data_);
+    return *p;
+  }
+
+  void
+  pop_back () noexcept
+  {
+    maybe_shrink (size () - 1);
+    --vector__size (data_);
+  }
+
+  iterator
+  insert (const_iterator pos, const T &value)
+  {
+    const size_type i = pos - data_;
+    const T copy = value;
+    grow (1);
+    std::memmove (data_ + i + 1, data_ + i, (size () - i) * sizeof (T));
+    data_[i] = copy;
+    ++vector__size (data_);
+    return data_ + i;
+  }
+
+  iterator
+  erase (const_iterator pos)
+  {
+    return erase (pos, pos + 1);
+  }
+
+  iterator
+  erase (const_iterator first, const_iterator last)
+  {
+    const size_type i = first - data_, n = last - first;
+    if (n)
+      {
+        std::memmove (data_ + i, data_ + i + n, (size () - i - n) * sizeof (T));
+        vector__size (data_) -= n;
+        maybe_shrink (size ());
+      }
+    return data_ + i;
+  }
+
+  void
+  resize (size_type n, const T &value = T ())
+  {
+    const size_type old = size ();
+    if (n > old)
+      {
+        const T copy = value;
+        reserve (n);
+        std::fill (data_ + old, data_ + n, copy);
+      }
+    if (data_)
+      {
+        vector__size (data_) = n;
+        if (n < old)
+          maybe_shrink (n);
+      }
+  }
+
+  void
+  clear () noexcept
+  {
+    if (data_)
+      {
+        vector__size (data_) = 0;
+        maybe_shrink (0);
+      }
+  }
+
+  void
+  swap (vector &other) noexcept
+  {
+    std::swap (data_, other.data_);
+    std::swap (resource_, other.resource_);
+  }
+
+  friend bool
+  operator== (const vector &a, const vector &b)
+  {
+    return a.size () == b.size () && std::equal (a.begin (), a.end (), b.begin ());
+  }
+
+  friend bool
+  operator!= (const vector &a, const vector &b)
+  {
+    return !(a == b);
+  }
+
+  friend void
+  swap (vector &a, vector &b) noexcept
+  {
+    a.swap (b);
+  }
+
+private:
+  static constexpr size_type alignment
+    = alignof (struct vector__header) > alignof (T)
+      ? alignof (struct vector__header) : alignof (T);
+
+  static size_type
+  bytes (size_type capacity) noexcept
+  {
+    return sizeof (struct vector__header) + capacity * sizeof (T);
+  }
+
+  /* Same growth as vector__grow_impl. */
+  void
+  grow (size_type n)
+  {
+    const size_type needed = size () + n;
+    size_type new_capacity = data_ ? capacity () * 2 : 16;
+    if (needed <= capacity ())
+      return;
+    if (new_capacity < needed)
+      new_capacity = needed;
+    if (new_capacity > VECTOR_MAX_SIZE && needed <= VECTOR_MAX_SIZE)
+      new_capacity = VECTOR_MAX_SIZE;
+    reallocate (new_capacity);
+  }
+
+  void
+  reallocate (size_type new_capacity)
+  {
+    if (!resource_)
+      {
+        data_ = static_cast<T *> (vector__resize_impl (data_, new_capacity,
+                                                       sizeof (T)));
+        return;
+      }
+    vector__check_size (new_capacity);
+    const size_type n = size () < new_capacity ? size () : new_capacity;
+    auto *const v = static_cast<struct vector__header *> (
+      resource_->allocate (bytes (new_capacity), alignment));
+    v->size = n;
+    v->capacity = new_capacity;
+    if (n)
+      std::memcpy (v->data, data_, n * sizeof (T));
+    deallocate (data_);
+    data_ = reinterpret_cast<T *> (v->data);
+  }
+
+  void
+  deallocate (T *data) noexcept
+  {
+    if (!data)
+      return;
+    if (resource_)
+      resource_->deallocate (vector__get (data), bytes (vector__capacity (data)),
+                             alignment);
+    else
+      vector_free (data);
+  }
+
+  /* Applies VECTOR_AUTO_SHRINK when the size becomes N. */
+  void
+  maybe_shrink (size_type n)
+  {
+#ifdef VECTOR_AUTO_SHRINK
+    if (!vector__needshrink (data_, n))
+      return;
+    if (!resource_)
+      {
+        data_ = static_cast<T *> (vector__shrink_impl (data_, n, sizeof (T)));
+        return;
+      }
+    size_type new_capacity = capacity ();
+    while (n < new_capacity / VECTOR_SHRINK_DIVISOR
+           && new_capacity / 2 >= VECTOR_SHRINK_MIN_CAPACITY)
+      new_capacity /= 2;
+    reallocate (new_capacity);
+#else
+    (void)n;
+#endif
+  }
+
+  T *data_ = nullptr;
+  std::pmr::memory_resource *resource_ = nullptr;
+};
+
+} /* namespace c_vector */
+
+#endif /* !VECTOR_HPP */
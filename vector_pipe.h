@@ -0,0 +1,156 @@
+#ifndef VECTOR_PIPE_H
+#define VECTOR_PIPE_H
+#include "vector.h"
+
+/* Lazy pipelines over vectors. All stages are expanded into the body of a
+   single loop over the source vector, so no intermediate vectors are created
+   and the data is only walked once.
+
+   Stages (at most 8 per pipeline), X is the name chosen for the element:
+     map (e)    - replaces X with E, the type of X becomes the type of E
+     filter (c) - drops elements for which C is false
+     take (n)   - stops after N elements got past this stage
+     skip (n)   - drops the first N elements that get to this stage
+
+   Example:
+     VECTOR(int) out = NULL;
+     vector_pipe_collect (out, v, x, map (x * 3), filter (x % 2 == 0), take (10));
+     long sum = 0;
+     vector_pipe_reduce (sum, sum + x, v, x, filter (x > 0));
+
+   These are statements, not expressions. Only available if VECTOR__DECLTYPE
+   is. */
+#ifdef VECTOR__DECLTYPE
+
+/* Appends the output of the pipeline to DST. DST is reserved once for the
+   largest possible output, the size of V or the smallest take limit if that
+   is less. DST must not be V. */
+#define vector_pipe_collect(dst, v, x, ...)                             \
+  VECTOR__PIPE_RUN ((v), x,                                             \
+                    VECTOR__PIPE_RESERVE ((dst), (v), x, __VA_ARGS__),  \
+                    (dst)[vector__size (dst)++] = x, __VA_ARGS__)
+
+/* Folds the output of the pipeline into ACC, OP is evaluated for each element
+   and assigned to ACC. */
+#define vector_pipe_reduce(acc, op, v, x, ...)\
+  VECTOR__PIPE_RUN ((v), x, , (acc) = (op), __VA_ARGS__)
+
+/* Adds the number of elements in the output of the pipeline to N. */
+#define vector_pipe_count(n, v, x, ...)\
+  VECTOR__PIPE_RUN ((v), x, , ++(n), __VA_ARGS__)
+
+/* SETUP runs once after the stage declarations, SINK for each element that
+   gets through all stages. */
+#define VECTOR__PIPE_RUN(v, x, setup, sink, ...)                          \
+  do                                                                      \
+    {                                                                     \
+      VECTOR__PIPE_EACH (VECTOR__PIPE_DECL, x, __VA_ARGS__)               \
+      setup                                                               \
+      for (size_t vector__pipe_i = 0, vector__pipe_n = vector_size (v);   \
+           vector__pipe_i < vector__pipe_n; ++vector__pipe_i)             \
+        {                                                                 \
+          VECTOR__DECLTYPE (*(v)) x = (v)[vector__pipe_i];                \
+          (void)x;                                                        \
+          VECTOR__PIPE_EACH (VECTOR__PIPE_STEP, x, __VA_ARGS__)           \
+          sink;                                                           \
+          VECTOR__PIPE_EACH (VECTOR__PIPE_END, x, __VA_ARGS__)            \
+        }                                                                 \
+    }                                                                     \
+  while (0)
+
+/* Every element of the output got past every take stage, so the smallest
+   limit bounds it. Uses the limits the declarations already evaluated. */
+#define VECTOR__PIPE_RESERVE(dst, v, x, ...)                              \
+  {                                                                       \
+    size_t vector__pipe_max = vector_size (v);                            \
+    VECTOR__PIPE_EACH (VECTOR__PIPE_LIMIT, x, __VA_ARGS__)                \
+    vector_reserve ((dst), vector_size (dst) + vector__pipe_max);         \
+  }
+
+/* Each stage is expanded three times: DECL before the loop, STEP before the
+   sink and END after it. The stage index I makes names unique. LIMIT lowers
+   the output bound for collect. */
+#define VECTOR__PIPE_DECL_map(x, i, ...)
+#define VECTOR__PIPE_STEP_map(x, i, ...)                                \
+  {                                                                     \
+    VECTOR__DECLTYPE (__VA_ARGS__) vector__pipe_t = (__VA_ARGS__);      \
+    {                                                                   \
+      VECTOR__DECLTYPE (vector__pipe_t) x = vector__pipe_t;           \
+      (void)x;
+#define VECTOR__PIPE_END_map(x, i, ...) }}
+#define VECTOR__PIPE_LIMIT_map(x, i, ...)
+
+#define VECTOR__PIPE_DECL_filter(x, i, ...)
+#define VECTOR__PIPE_STEP_filter(x, i, ...)\
+  if (!(__VA_ARGS__)) continue;
+#define VECTOR__PIPE_END_filter(x, i, ...)
+#define VECTOR__PIPE_LIMIT_filter(x, i, ...)
+
+#define VECTOR__PIPE_DECL_take(x, i, ...)\
+  size_t vector__pipe_count_##i = 0, vector__pipe_limit_##i = (__VA_ARGS__);
+#define VECTOR__PIPE_STEP_take(x, i, ...)                   \
+  if (vector__pipe_count_##i >= vector__pipe_limit_##i)     \
+    break;                                                  \
+  ++vector__pipe_count_##i;
+/* Stop right away instead of looking at the next element. */
+#define VECTOR__PIPE_END_take(x, i, ...)                    \
+  if (vector__pipe_count_##i >= vector__pipe_limit_##i)     \
+    break;
+#define VECTOR__PIPE_LIMIT_take(x, i, ...)                  \
+  if (vector__pipe_limit_##i < vector__pipe_max)            \
+    vector__pipe_max = vector__pipe_limit_##i;
+
+#define VECTOR__PIPE_DECL_skip(x, i, ...)\
+  size_t vector__pipe_count_##i = 0, vector__pipe_limit_##i = (__VA_ARGS__);
+#define VECTOR__PIPE_STEP_skip(x, i, ...)                   \
+  if (vector__pipe_count_##i < vector__pipe_limit_##i)      \
+    {                                                       \
+      ++vector__pipe_count_##i;                             \
+      continue;                                             \
+    }
+#define VECTOR__PIPE_END_skip(x, i, ...)
+#define VECTOR__PIPE_LIMIT_skip(x, i, ...)
+
+/* `map (e)` -> `map, e` so the stage name can be pasted onto M. */
+#define VECTOR__PIPE_KIND_map(...) map, __VA_ARGS__
+#define VECTOR__PIPE_KIND_filter(...) filter, __VA_ARGS__
+#define VECTOR__PIPE_KIND_take(...) take, __VA_ARGS__
+#define VECTOR__PIPE_KIND_skip(...) skip, __VA_ARGS__
+
+#define VECTOR__PIPE_APPLY(M, x, i, stage)\
+  VECTOR__PIPE_APPLY_ (M, x, i, VECTOR__PIPE_KIND_##stage)
+#define VECTOR__PIPE_APPLY_(M, x, i, kind_and_arg)\
+  VECTOR__PIPE_APPLY__ (M, x, i, kind_and_arg)
+#define VECTOR__PIPE_APPLY__(M, x, i, kind, ...)\
+  M##_##kind (x, i, __VA_ARGS__)
+
+#define VECTOR__PIPE_EACH(M, x, ...)                               \
+  __VA_OPT__ (VECTOR__PIPE_CAT (VECTOR__PIPE_EACH_,                \
+                                VECTOR__PIPE_NARGS (__VA_ARGS__))  \
+              (M, x, __VA_ARGS__))
+#define VECTOR__PIPE_CAT(a, b) VECTOR__PIPE_CAT_ (a, b)
+#define VECTOR__PIPE_CAT_(a, b) a##b
+#define VECTOR__PIPE_NARGS(...)\
+  VECTOR__PIPE_NARGS_ (__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define VECTOR__PIPE_NARGS_(_1, _2, _3, _4, _5, _6, _7, _8, n, ...) n
+
+#define VECTOR__PIPE_EACH_1(M, x, s)\
+  VECTOR__PIPE_APPLY (M, x, 1, s)
+#define VECTOR__PIPE_EACH_2(M, x, s, ...)\
+  VECTOR__PIPE_APPLY (M, x, 2, s) VECTOR__PIPE_EACH_1 (M, x, __VA_ARGS__)
+#define VECTOR__PIPE_EACH_3(M, x, s, ...)\
+  VECTOR__PIPE_APPLY (M, x, 3, s) VECTOR__PIPE_EACH_2 (M, x, __VA_ARGS__)
+#define VECTOR__PIPE_EACH_4(M, x, s, ...)\
+  VECTOR__PIPE_APPLY (M, x, 4, s) VECTOR__PIPE_EACH_3 (M, x, __VA_ARGS__)
+#define VECTOR__PIPE_EACH_5(M, x, s, ...)\
+  VECTOR__PIPE_APPLY (M, x, 5, s) VECTOR__PIPE_EACH_4 (M, x, __VA_ARGS__)
+#define VECTOR__PIPE_EACH_6(M, x, s, ...)\
+  VECTOR__PIPE_APPLY (M, x, 6, s) VECTOR__PIPE_EACH_5 (M, x, __VA_ARGS__)
+#define VECTOR__PIPE_EACH_7(M, x, s, ...)\
+  VECTOR__PIPE_APPLY (M, x, 7, s) VECTOR__PIPE_EACH_6 (M, x, __VA_ARGS__)
+#define VECTOR__PIPE_EACH_8(M, x, s, ...)\
+  VECTOR__PIPE_APPLY (M, x, 8, s) VECTOR__PIPE_EACH_7 (M, x, __VA_ARGS__)
+
+#endif /* VECTOR__DECLTYPE */
+
+#endif /* !VECTOR_PIPE_H */